@@ -0,0 +1,142 @@
+// Time per element of division, sqrt and atan2 over arrays in which a
+// fraction of the inputs is invalid (zero divisors, negative or NaN
+// arguments): the throwing Number operators, one try/catch per element,
+// against the status flag arrays of NumberChecked.h.
+//
+// The prebuilt libNumberLibrary.a predates NumberChecked.cpp, so build from
+// the sources:
+//
+//   g++ -std=c++17 -O2 CheckedBench.cpp NumberChecked.cpp NumberLibrary.cpp -o CheckedBench
+//   ./CheckedBench [count]
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#include "NumberChecked.h"
+#include "NumberLibrary.h"
+
+namespace {
+
+const double QUIET_NAN = std::numeric_limits<double>::quiet_NaN();
+
+struct Inputs {
+    std::vector<double> a;  // dividends, y of atan2
+    std::vector<double> b;  // divisors, x of atan2
+    std::vector<double> c;  // sqrt arguments
+};
+
+// Valid inputs are a in [1, 2), b in [-2, -1) or [1, 2) and c in [1, 2).
+// At roughly invalidFraction of the positions b becomes zero or NaN and c
+// negative or NaN.
+Inputs makeInputs(size_t count, double invalidFraction, unsigned seed)
+{
+    std::mt19937_64 random(seed);
+    std::uniform_real_distribution<double> value(1.0, 2.0);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    Inputs inputs;
+    inputs.a.resize(count);
+    inputs.b.resize(count);
+    inputs.c.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        inputs.a[i] = value(random);
+        inputs.b[i] = unit(random) < 0.5 ? value(random) : -value(random);
+        inputs.c[i] = value(random);
+        if (unit(random) < invalidFraction) {
+            const bool nan = unit(random) < 0.25;
+            inputs.b[i] = nan ? QUIET_NAN : 0.0;
+            inputs.c[i] = nan ? QUIET_NAN : -inputs.c[i];
+        }
+    }
+    return inputs;
+}
+
+template <typename Run>
+double nanosecondsPerElement(Run run, size_t count)
+{
+    const int repeats = 5;
+    double best = 0.0;
+    for (int r = 0; r < repeats; ++r) {
+        const auto start = std::chrono::steady_clock::now();
+        run();
+        const auto stop = std::chrono::steady_clock::now();
+        const double ns = std::chrono::duration<double, std::nano>(stop - start).count() / count;
+        if (r == 0 || ns < best) best = ns;
+    }
+    return best;
+}
+
+void report(const char* name, double fraction, double throwingNs, double checkedNs)
+{
+    std::printf("%-6s %8.1f%% %12.3f %12.3f %8.2fx\n", name, fraction * 100.0, throwingNs, checkedNs,
+                throwingNs / checkedNs);
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    const long count = argc > 1 ? std::atol(argv[1]) : 1 << 20;
+    if (count <= 0) {
+        std::fprintf(stderr, "usage: %s [count]\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<double> out(count);
+    double sink = 0.0;
+    std::printf("%-6s %9s %12s %12s %9s\n", "op", "invalid", "throwing ns", "checked ns", "speedup");
+    for (double fraction : { 0.0, 0.001, 0.01, 0.1 }) {
+        const Inputs inputs = makeInputs(count, fraction, 42);
+        const double* a = inputs.a.data();
+        const double* b = inputs.b.data();
+        const double* c = inputs.c.data();
+        unsigned status = 0;
+
+        // The throwing operators pass NaN through; the checked ones flag it.
+        const double divideThrowing = nanosecondsPerElement([&] {
+            for (long i = 0; i < count; ++i) {
+                try {
+                    out[i] = (Number(a[i]) / Number(b[i])).getValue();
+                } catch (const std::runtime_error&) {
+                    out[i] = QUIET_NAN;
+                }
+            }
+        }, count);
+        const double divideChecked = nanosecondsPerElement([&] { status |= numberDivideArray(a, b, out.data(), count); },
+                                                           count);
+        report("div", fraction, divideThrowing, divideChecked);
+        sink += out[count / 2];
+
+        const double sqrtThrowing = nanosecondsPerElement([&] {
+            for (long i = 0; i < count; ++i) {
+                try {
+                    out[i] = numberSqrt(Number(c[i])).getValue();
+                } catch (const std::domain_error&) {
+                    out[i] = QUIET_NAN;
+                }
+            }
+        }, count);
+        const double sqrtChecked = nanosecondsPerElement([&] { status |= numberSqrtArray(c, out.data(), count); },
+                                                         count);
+        report("sqrt", fraction, sqrtThrowing, sqrtChecked);
+        sink += out[count / 2];
+
+        const double atan2Plain = nanosecondsPerElement([&] {
+            for (long i = 0; i < count; ++i) {
+                out[i] = numberAtan2(Number(a[i]), Number(b[i])).getValue();
+            }
+        }, count);
+        const double atan2Checked = nanosecondsPerElement([&] { status |= numberAtan2Array(a, b, out.data(), count); },
+                                                          count);
+        report("atan2", fraction, atan2Plain, atan2Checked);
+        sink += out[count / 2];
+
+        std::printf("       status flags %u\n", status);
+    }
+    std::printf("(checksum %g)\n", sink);
+    return 0;
+}
@@ -0,0 +1,95 @@
+// Time per vector of turning Vectors into text: the std::ostringstream
+// formatting toString used to do (kept here as the baseline), toString,
+// which now uses std::to_chars, and the allocation free format_to,
+// append_to and VectorBatch::append_to.
+//
+// The prebuilt libVector.so and libNumberLibrary.a predate VectorBatch and
+// format_to / append_to, so build from the sources:
+//
+//   g++ -std=c++17 -O2 FormatBench.cpp VectorBatch.cpp VectorDLL.cpp NumberLibrary.cpp -o FormatBench
+//   ./FormatBench [count]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <sstream>
+#include <string>
+#include "NumberLibrary.h"
+#include "VectorBatch.h"
+#include "VectorDLL.h"
+
+namespace {
+
+// Number::toString and Vector::toString before std::to_chars.
+std::string streamToString(const Number& number)
+{
+    std::ostringstream ss;
+    ss << number.getValue();
+    return ss.str();
+}
+
+std::string streamToString(const Vector& vector)
+{
+    std::ostringstream ss;
+    ss << "(" << streamToString(vector.getX()) << ", " << streamToString(vector.getY()) << ")";
+    return ss.str();
+}
+
+template <typename Run>
+double nanosecondsPer(Run run, size_t count)
+{
+    const auto start = std::chrono::steady_clock::now();
+    run();
+    const auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(stop - start).count() / count;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    const long count = argc > 1 ? std::atol(argv[1]) : 1000000;
+    if (count <= 0) {
+        std::fprintf(stderr, "usage: %s [count]\n", argv[0]);
+        return 1;
+    }
+
+    std::mt19937_64 random(7);
+    std::uniform_real_distribution<double> value(-1000.0, 1000.0);
+    VectorBatch batch;
+    for (long i = 0; i < count; ++i) {
+        batch.push_back(Vector(Number(value(random)), Number(value(random))));
+    }
+
+    size_t characters = 0;
+    std::printf("%-28s %10s\n", "formatting", "ns/vector");
+    std::printf("%-28s %10.1f\n", "ostringstream (old toString)", nanosecondsPer([&] {
+        for (long i = 0; i < count; ++i) characters += streamToString(batch.get(i)).size();
+    }, count));
+    std::printf("%-28s %10.1f\n", "toString", nanosecondsPer([&] {
+        for (long i = 0; i < count; ++i) characters += batch.get(i).toString().size();
+    }, count));
+    std::printf("%-28s %10.1f\n", "format_to, shortest", nanosecondsPer([&] {
+        char buffer[VECTOR_FORMAT_MAX];
+        for (long i = 0; i < count; ++i) characters += batch.get(i).format_to(buffer, sizeof buffer);
+    }, count));
+
+    std::string line;
+    std::printf("%-28s %10.1f\n", "append_to, reused string", nanosecondsPer([&] {
+        for (long i = 0; i < count; ++i) {
+            line.clear();
+            batch.get(i).append_to(line);
+            characters += line.size();
+        }
+    }, count));
+
+    std::string all;
+    std::printf("%-28s %10.1f\n", "VectorBatch::append_to", nanosecondsPer([&] {
+        batch.append_to(all);
+        characters += all.size();
+    }, count));
+
+    std::printf("(%zu characters)\n", characters);
+    return 0;
+}
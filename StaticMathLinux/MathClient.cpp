@@ -1,6 +1,13 @@
+// Demo of Number, Vector and VectorBatch. The prebuilt libVector.so and
+// libNumberLibrary.a predate VectorBatch, so build from the sources:
+//
+//   g++ -std=c++17 -O2 MathClient.cpp VectorBatch.cpp VectorDLL.cpp NumberLibrary.cpp -o MathClient
+
 #include <iostream>
 #include "NumberLibrary.h"
 #include "VectorDLL.h"
+#include "VectorBatch.h"
+#include "MathExpression.h"
 
 int main()
 {
@@ -9,6 +16,9 @@ int main()
     Number c = a * b + NUMBER_ONE;
     std::cout << "a = " << a.toString() << ", b = " << b.toString() << ", c = " << c.toString() << "\n";
 
+    Number lazyC = math_expr::value(math_expr::lazy(a) * b + NUMBER_ONE);
+    std::cout << "c as one expression = " << lazyC.toString() << "\n";
+
     Vector v1 = VECTOR_ONE_ONE;
     Vector v2 = Vector(сreateNumber(2.0), сreateNumber(3.0));
     Vector v3 = v1 + v2;
@@ -21,5 +31,26 @@ int main()
     Number ang = v3.angle(); 
     std::cout << "v3 radius = " << r.toString() << ", angle (rad) = " << ang.toString() << "\n";
 
+    VectorBatch batch;
+    batch.push_back(v1);
+    batch.push_back(v2);
+    batch.push_back(v3);
+    std::vector<double> radii(batch.size());
+    std::vector<double> angles(batch.size());
+    batch.radius(radii.data());
+    batch.angle(angles.data());
+    std::cout << "batch (" << VectorBatch::isa() << "):\n";
+    for (size_t i = 0; i < batch.size(); ++i) {
+        std::cout << "  " << batch.get(i).toString() << " radius = " << radii[i] << ", angle (rad) = " << angles[i] << "\n";
+    }
+
+    // batch = batch + batch / 2 and the new radii in one pass each.
+    math_expr::assign(batch, math_expr::vectors(batch) + math_expr::vectors(batch) / 2.0);
+    math_expr::evaluate(math_expr::radius(math_expr::vectors(batch)), radii.data(), batch.size());
+    std::cout << "batch * 1.5:\n";
+    for (size_t i = 0; i < batch.size(); ++i) {
+        std::cout << "  " << batch.get(i).toString() << " radius = " << radii[i] << "\n";
+    }
+
     return 0;
 }
@@ -0,0 +1,396 @@
+#ifndef MATH_EXPRESSION
+#define MATH_EXPRESSION
+
+#include "VectorInline.h"
+#include "VectorBatch.h"
+#include "VectorDLL.h"
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+
+// Expression templates over Numbers, Vectors and VectorBatch arrays. An
+// arithmetic expression with at least one math_expr operand builds a tree
+// of small nodes instead of computing anything; evaluate, assign or value
+// then runs the whole tree in one loop, element by element, without the
+// temporary Number / Vector / array of every operator:
+//
+//     math_expr::assign(out, math_expr::vectors(a) + math_expr::vectors(b) * scale);
+//     math_expr::evaluate(math_expr::radius(math_expr::vectors(out)), radii, out.size());
+//     Number c = math_expr::value(math_expr::lazy(a) * b + NUMBER_ONE);
+//
+// Each node rounds like the operator it stands for, in the same order, so
+// the results are bit for bit those of Number and Vector, provided the
+// compiler does not contract a * b + c into a fused multiply-add. GCC does
+// that by default where FMA is enabled (-march=native), as it may for
+// inline_math::Vector::radius; build with -ffp-contract=off to keep the
+// results identical there. The nodes are plain inline code and compile
+// with the caller's options: an optimize pragma here would keep GCC from
+// inlining them into code built without it. Ask for a fused multiply-add
+// with fusedMultiplyAdd, which rounds once and so differs from a * b + c in
+// the last bit; it is a single instruction where FMA is enabled and a libm
+// call otherwise.
+//
+// Division follows IEEE (infinity or NaN for a zero divisor) and numberSqrt
+// of a negative value gives NaN: the nodes do not throw like Number does.
+//
+// Operands of size 0 are scalars (Numbers, Vectors, doubles) and are
+// broadcast; arrays in one expression must all have the same size.
+
+namespace math_expr {
+
+template <typename E>
+struct NumberExpression {
+    const E& self() const { return static_cast<const E&>(*this); }
+};
+
+template <typename E>
+struct VectorExpression {
+    const E& self() const { return static_cast<const E&>(*this); }
+};
+
+template <typename T>
+constexpr bool isNumberExpression = std::is_base_of<NumberExpression<T>, T>::value;
+
+template <typename T>
+constexpr bool isVectorExpression = std::is_base_of<VectorExpression<T>, T>::value;
+
+template <typename T>
+constexpr bool isExpression = isNumberExpression<T> || isVectorExpression<T>;
+
+// Size of a node over two operands of sizes a and b.
+inline size_t combinedSize(size_t a, size_t b)
+{
+    if (a != 0 && b != 0 && a != b) throw std::invalid_argument("math_expr: array sizes differ");
+    return a != 0 ? a : b;
+}
+
+// Leaves.
+
+class NumberConstant : public NumberExpression<NumberConstant> {
+public:
+    explicit NumberConstant(double value) : _value(value) {}
+    size_t size() const { return 0; }
+    double at(size_t) const { return _value; }
+
+private:
+    double _value;
+};
+
+class NumberColumn : public NumberExpression<NumberColumn> {
+public:
+    NumberColumn(const double* data, size_t count) : _data(data), _count(count) {}
+    size_t size() const { return _count; }
+    double at(size_t i) const { return _data[i]; }
+
+private:
+    const double* _data;
+    size_t _count;
+};
+
+class VectorConstant : public VectorExpression<VectorConstant> {
+public:
+    VectorConstant(double x, double y) : _x(x), _y(y) {}
+    size_t size() const { return 0; }
+    double xAt(size_t) const { return _x; }
+    double yAt(size_t) const { return _y; }
+
+private:
+    double _x;
+    double _y;
+};
+
+class VectorColumns : public VectorExpression<VectorColumns> {
+public:
+    VectorColumns(const double* x, const double* y, size_t count) : _x(x), _y(y), _count(count) {}
+    size_t size() const { return _count; }
+    double xAt(size_t i) const { return _x[i]; }
+    double yAt(size_t i) const { return _y[i]; }
+
+private:
+    const double* _x;
+    const double* _y;
+    size_t _count;
+};
+
+// Turning operands into nodes. Nodes are held by value: they are a few
+// pointers or doubles, and an expression may outlive the temporaries it was
+// built from.
+
+inline NumberConstant lazy(double value) { return NumberConstant(value); }
+inline NumberConstant lazy(const Number& number) { return NumberConstant(number.getValue()); }
+inline NumberConstant lazy(const inline_math::Number& number) { return NumberConstant(number.getValue()); }
+inline VectorConstant lazy(const Vector& vector) { return VectorConstant(vector.getX().getValue(), vector.getY().getValue()); }
+inline VectorConstant lazy(const inline_math::Vector& vector)
+{
+    return VectorConstant(vector.getX().getValue(), vector.getY().getValue());
+}
+template <typename E>
+E lazy(const NumberExpression<E>& expression) { return expression.self(); }
+template <typename E>
+E lazy(const VectorExpression<E>& expression) { return expression.self(); }
+
+inline NumberColumn column(const double* data, size_t count) { return NumberColumn(data, count); }
+inline NumberColumn xs(const VectorBatch& batch) { return NumberColumn(batch.x(), batch.size()); }
+inline NumberColumn ys(const VectorBatch& batch) { return NumberColumn(batch.y(), batch.size()); }
+inline VectorColumns vectors(const VectorBatch& batch) { return VectorColumns(batch.x(), batch.y(), batch.size()); }
+
+template <typename T>
+using NumberOperand = std::enable_if_t<isNumberExpression<decltype(lazy(std::declval<const T&>()))>,
+                                       decltype(lazy(std::declval<const T&>()))>;
+
+template <typename T>
+using VectorOperand = std::enable_if_t<isVectorExpression<decltype(lazy(std::declval<const T&>()))>,
+                                       decltype(lazy(std::declval<const T&>()))>;
+
+// Inner nodes.
+
+struct Add { static double apply(double a, double b) { return a + b; } };
+struct Subtract { static double apply(double a, double b) { return a - b; } };
+struct Multiply { static double apply(double a, double b) { return a * b; } };
+struct Divide { static double apply(double a, double b) { return a / b; } };
+
+template <typename Op, typename L, typename R>
+class NumberBinary : public NumberExpression<NumberBinary<Op, L, R>> {
+public:
+    NumberBinary(L left, R right) : _left(left), _right(right) {}
+    size_t size() const { return combinedSize(_left.size(), _right.size()); }
+    double at(size_t i) const { return Op::apply(_left.at(i), _right.at(i)); }
+
+private:
+    L _left;
+    R _right;
+};
+
+// Component-wise: Vector + Vector.
+template <typename Op, typename L, typename R>
+class VectorBinary : public VectorExpression<VectorBinary<Op, L, R>> {
+public:
+    VectorBinary(L left, R right) : _left(left), _right(right) {}
+    size_t size() const { return combinedSize(_left.size(), _right.size()); }
+    double xAt(size_t i) const { return Op::apply(_left.xAt(i), _right.xAt(i)); }
+    double yAt(size_t i) const { return Op::apply(_left.yAt(i), _right.yAt(i)); }
+
+private:
+    L _left;
+    R _right;
+};
+
+// Both components against one number: Vector * Number, Vector / Number.
+template <typename Op, typename V, typename N>
+class VectorScaled : public VectorExpression<VectorScaled<Op, V, N>> {
+public:
+    VectorScaled(V vector, N number) : _vector(vector), _number(number) {}
+    size_t size() const { return combinedSize(_vector.size(), _number.size()); }
+    double xAt(size_t i) const { return Op::apply(_vector.xAt(i), _number.at(i)); }
+    double yAt(size_t i) const { return Op::apply(_vector.yAt(i), _number.at(i)); }
+
+private:
+    V _vector;
+    N _number;
+};
+
+template <typename V>
+class VectorX : public NumberExpression<VectorX<V>> {
+public:
+    explicit VectorX(V vector) : _vector(vector) {}
+    size_t size() const { return _vector.size(); }
+    double at(size_t i) const { return _vector.xAt(i); }
+
+private:
+    V _vector;
+};
+
+template <typename V>
+class VectorY : public NumberExpression<VectorY<V>> {
+public:
+    explicit VectorY(V vector) : _vector(vector) {}
+    size_t size() const { return _vector.size(); }
+    double at(size_t i) const { return _vector.yAt(i); }
+
+private:
+    V _vector;
+};
+
+// Vector::radius: xsq, ysq and their sum rounded one after the other.
+template <typename V>
+class VectorRadius : public NumberExpression<VectorRadius<V>> {
+public:
+    explicit VectorRadius(V vector) : _vector(vector) {}
+    size_t size() const { return _vector.size(); }
+    double at(size_t i) const
+    {
+        const double x = _vector.xAt(i);
+        const double y = _vector.yAt(i);
+        return std::sqrt(x * x + y * y);
+    }
+
+private:
+    V _vector;
+};
+
+template <typename Y, typename X>
+class NumberAtan2 : public NumberExpression<NumberAtan2<Y, X>> {
+public:
+    NumberAtan2(Y y, X x) : _y(y), _x(x) {}
+    size_t size() const { return combinedSize(_y.size(), _x.size()); }
+    double at(size_t i) const { return std::atan2(_y.at(i), _x.at(i)); }
+
+private:
+    Y _y;
+    X _x;
+};
+
+template <typename N>
+class NumberSqrt : public NumberExpression<NumberSqrt<N>> {
+public:
+    explicit NumberSqrt(N number) : _number(number) {}
+    size_t size() const { return _number.size(); }
+    double at(size_t i) const { return std::sqrt(_number.at(i)); }
+
+private:
+    N _number;
+};
+
+template <typename A, typename B, typename C>
+class FusedMultiplyAdd : public NumberExpression<FusedMultiplyAdd<A, B, C>> {
+public:
+    FusedMultiplyAdd(A a, B b, C c) : _a(a), _b(b), _c(c) {}
+    size_t size() const { return combinedSize(combinedSize(_a.size(), _b.size()), _c.size()); }
+    double at(size_t i) const { return std::fma(_a.at(i), _b.at(i), _c.at(i)); }
+
+private:
+    A _a;
+    B _b;
+    C _c;
+};
+
+// Operators and functions. The operators take part only when one side is
+// already an expression (found by argument dependent lookup), so Number and
+// Vector arithmetic on their own stays eager.
+
+#define MATH_EXPR_NUMBER_OPERATOR(symbol, Op)                                                     \
+    template <typename L, typename R, typename = std::enable_if_t<isExpression<L> || isExpression<R>>> \
+    NumberBinary<Op, NumberOperand<L>, NumberOperand<R>> operator symbol(const L& left, const R& right) \
+    {                                                                                             \
+        return NumberBinary<Op, NumberOperand<L>, NumberOperand<R>>(lazy(left), lazy(right));     \
+    }
+
+MATH_EXPR_NUMBER_OPERATOR(+, Add)
+MATH_EXPR_NUMBER_OPERATOR(-, Subtract)
+MATH_EXPR_NUMBER_OPERATOR(*, Multiply)
+MATH_EXPR_NUMBER_OPERATOR(/, Divide)
+
+#undef MATH_EXPR_NUMBER_OPERATOR
+
+template <typename L, typename R, typename = std::enable_if_t<isExpression<L> || isExpression<R>>>
+VectorBinary<Add, VectorOperand<L>, VectorOperand<R>> operator+(const L& left, const R& right)
+{
+    return VectorBinary<Add, VectorOperand<L>, VectorOperand<R>>(lazy(left), lazy(right));
+}
+
+template <typename V, typename N, typename = std::enable_if_t<isExpression<V> || isExpression<N>>>
+VectorScaled<Multiply, VectorOperand<V>, NumberOperand<N>> operator*(const V& vector, const N& number)
+{
+    return VectorScaled<Multiply, VectorOperand<V>, NumberOperand<N>>(lazy(vector), lazy(number));
+}
+
+template <typename N, typename V, typename = std::enable_if_t<isExpression<N> || isExpression<V>>>
+VectorScaled<Multiply, VectorOperand<V>, NumberOperand<N>> operator*(const N& number, const V& vector)
+{
+    return VectorScaled<Multiply, VectorOperand<V>, NumberOperand<N>>(lazy(vector), lazy(number));
+}
+
+template <typename V, typename N, typename = std::enable_if_t<isExpression<V> || isExpression<N>>>
+VectorScaled<Divide, VectorOperand<V>, NumberOperand<N>> operator/(const V& vector, const N& number)
+{
+    return VectorScaled<Divide, VectorOperand<V>, NumberOperand<N>>(lazy(vector), lazy(number));
+}
+
+template <typename V>
+VectorX<VectorOperand<V>> getX(const V& vector) { return VectorX<VectorOperand<V>>(lazy(vector)); }
+
+template <typename V>
+VectorY<VectorOperand<V>> getY(const V& vector) { return VectorY<VectorOperand<V>>(lazy(vector)); }
+
+template <typename V>
+VectorRadius<VectorOperand<V>> radius(const V& vector) { return VectorRadius<VectorOperand<V>>(lazy(vector)); }
+
+template <typename V>
+NumberAtan2<VectorY<VectorOperand<V>>, VectorX<VectorOperand<V>>> angle(const V& vector)
+{
+    return NumberAtan2<VectorY<VectorOperand<V>>, VectorX<VectorOperand<V>>>(getY(vector), getX(vector));
+}
+
+template <typename N>
+NumberSqrt<NumberOperand<N>> numberSqrt(const N& number) { return NumberSqrt<NumberOperand<N>>(lazy(number)); }
+
+template <typename Y, typename X>
+NumberAtan2<NumberOperand<Y>, NumberOperand<X>> numberAtan2(const Y& y, const X& x)
+{
+    return NumberAtan2<NumberOperand<Y>, NumberOperand<X>>(lazy(y), lazy(x));
+}
+
+// std::fma(a, b, c): one rounding instead of the two of a * b + c.
+template <typename A, typename B, typename C>
+FusedMultiplyAdd<NumberOperand<A>, NumberOperand<B>, NumberOperand<C>> fusedMultiplyAdd(const A& a, const B& b,
+                                                                                       const C& c)
+{
+    return FusedMultiplyAdd<NumberOperand<A>, NumberOperand<B>, NumberOperand<C>>(lazy(a), lazy(b), lazy(c));
+}
+
+// Evaluation.
+
+// out[i] = expression[i] for i < count. Throws std::invalid_argument when
+// the expression is over arrays of another size.
+template <typename E>
+inline void evaluate(const NumberExpression<E>& expression, double* out, size_t count)
+{
+    const E& e = expression.self();
+    if (combinedSize(e.size(), count) != count) throw std::invalid_argument("math_expr: array sizes differ");
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = e.at(i);
+    }
+}
+
+// batch[i] = expression[i]. batch may appear in the expression: each
+// element is read completely before it is written.
+template <typename E>
+inline void assign(VectorBatch& batch, const VectorExpression<E>& expression)
+{
+    const E& e = expression.self();
+    const size_t count = batch.size();
+    if (combinedSize(e.size(), count) != count) throw std::invalid_argument("math_expr: array sizes differ");
+    double* x = batch.x();
+    double* y = batch.y();
+    for (size_t i = 0; i < count; ++i) {
+        const double xi = e.xAt(i);
+        const double yi = e.yAt(i);
+        x[i] = xi;
+        y[i] = yi;
+    }
+}
+
+// The value of an expression without arrays, as a Number (or, for example,
+// an inline_math::Number). Throws std::invalid_argument for array
+// expressions.
+template <typename N = Number, typename E>
+inline N value(const NumberExpression<E>& expression)
+{
+    const E& e = expression.self();
+    if (e.size() != 0) throw std::invalid_argument("math_expr: value of an array expression");
+    return N(e.at(0));
+}
+
+template <typename V = Vector, typename E>
+inline V value(const VectorExpression<E>& expression)
+{
+    using N = decltype(std::declval<const V&>().getX());
+    const E& e = expression.self();
+    if (e.size() != 0) throw std::invalid_argument("math_expr: value of an array expression");
+    return V(N(e.xAt(0)), N(e.yAt(0)));
+}
+
+} // namespace math_expr
+
+#endif // MATH_EXPRESSION
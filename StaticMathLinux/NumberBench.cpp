@@ -0,0 +1,126 @@
+// Latency of one Number / Vector operation through the libraries
+// (libNumberLibrary.a, libVector.so) and through the header-only
+// NumberInline.h / VectorInline.h. Each loop feeds its result into the next
+// iteration, so the time per iteration is the latency of the operation
+// including, for the library, the call.
+//
+// libVector.so is not checked in and the prebuilt libNumberLibrary.a is
+// older than the sources, so build both libraries first; the bench links
+// against them, keeping the calls across the library boundary it measures:
+//
+//   g++ -std=c++17 -O2 -c NumberLibrary.cpp -o NumberLibrary.o
+//   ar rcs libNumberLibrary.a NumberLibrary.o
+//   g++ -std=c++17 -O2 -fPIC -shared VectorDLL.cpp NumberLibrary.cpp -o libVector.so
+//   g++ -std=c++17 -O2 NumberBench.cpp -L. -lVector -lNumberLibrary -o NumberBench
+//   LD_LIBRARY_PATH=. ./NumberBench [iterations]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include "NumberLibrary.h"
+#include "VectorDLL.h"
+#include "NumberInline.h"
+#include "VectorInline.h"
+
+namespace {
+
+// Read through volatile so the compiler cannot fold the loops.
+volatile double seedStart = 1.0;
+volatile double seedStep = 1e-9;
+volatile double seedScale = 1.0000000001;
+
+template <typename N>
+double chainAdd(long iterations)
+{
+    N x(seedStart);
+    const N step(seedStep);
+    for (long i = 0; i < iterations; ++i) {
+        x = x + step;
+    }
+    return x.getValue();
+}
+
+template <typename N>
+double chainMultiply(long iterations)
+{
+    N x(seedStart);
+    const N scale(seedScale);
+    for (long i = 0; i < iterations; ++i) {
+        x = x * scale;
+    }
+    return x.getValue();
+}
+
+template <typename N>
+double chainDivide(long iterations)
+{
+    N x(seedStart);
+    const N scale(seedScale);
+    for (long i = 0; i < iterations; ++i) {
+        x = x / scale;
+    }
+    return x.getValue();
+}
+
+template <typename N, typename V>
+double chainVectorAdd(long iterations)
+{
+    V v{ N(seedStart), N(seedStart) };
+    const V step{ N(seedStep), N(seedStep) };
+    for (long i = 0; i < iterations; ++i) {
+        v = v + step;
+    }
+    return v.getX().getValue() + v.getY().getValue();
+}
+
+template <typename N, typename V>
+double chainRadius(long iterations)
+{
+    N r(seedStart);
+    const N y(seedStep);
+    for (long i = 0; i < iterations; ++i) {
+        r = V(r, y).radius();
+    }
+    return r.getValue();
+}
+
+// Nanoseconds per iteration of run(iterations); the result is summed into
+// sink so the loop is not dropped.
+template <typename Run>
+double measure(Run run, long iterations, double& sink)
+{
+    const auto start = std::chrono::steady_clock::now();
+    sink += run(iterations);
+    const auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(stop - start).count() / iterations;
+}
+
+template <typename Library, typename Inline>
+void report(const char* name, Library library, Inline inlined, long iterations, double& sink)
+{
+    const double libraryNs = measure(library, iterations, sink);
+    const double inlineNs = measure(inlined, iterations, sink);
+    std::printf("%-12s %10.3f %10.3f %8.2fx\n", name, libraryNs, inlineNs, libraryNs / inlineNs);
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    const long iterations = argc > 1 ? std::atol(argv[1]) : 50000000;
+    if (iterations <= 0) {
+        std::fprintf(stderr, "usage: %s [iterations]\n", argv[0]);
+        return 1;
+    }
+
+    namespace im = inline_math;
+    double sink = 0.0;
+    std::printf("%-12s %10s %10s %9s\n", "op", "library ns", "inline ns", "speedup");
+    report("Number +", chainAdd<Number>, chainAdd<im::Number>, iterations, sink);
+    report("Number *", chainMultiply<Number>, chainMultiply<im::Number>, iterations, sink);
+    report("Number /", chainDivide<Number>, chainDivide<im::Number>, iterations, sink);
+    report("Vector +", chainVectorAdd<Number, Vector>, chainVectorAdd<im::Number, im::Vector>, iterations, sink);
+    report("radius", chainRadius<Number, Vector>, chainRadius<im::Number, im::Vector>, iterations, sink);
+    std::printf("(checksum %g)\n", sink);
+    return 0;
+}
@@ -0,0 +1,114 @@
+#include "NumberChecked.h"
+#include <emmintrin.h>
+#include <cmath>
+
+// The array loops use SSE2, which every x86-64 CPU has, two doubles at a
+// time. The comparisons of a pair are or'ed into masks and only turned into
+// flags after the loop, and _mm_sqrt_pd does not take the errno path of
+// std::sqrt that keeps the compiler from vectorizing a sqrt loop. Division
+// and sqrt are limited by the divider, which is not faster per element on
+// wider vectors, so AVX versions would gain little.
+
+namespace {
+
+unsigned divisionStatus(double a, double b)
+{
+	return (b == 0.0 ? NUMBER_STATUS_DIVISION_BY_ZERO : 0)
+		| (std::isnan(a) || std::isnan(b) ? NUMBER_STATUS_NAN_ARGUMENT : 0);
+}
+
+unsigned sqrtStatus(double num)
+{
+	return (num < 0.0 ? NUMBER_STATUS_SQRT_OF_NEGATIVE : 0) | (std::isnan(num) ? NUMBER_STATUS_NAN_ARGUMENT : 0);
+}
+
+unsigned atan2Status(double y, double x)
+{
+	return std::isnan(y) || std::isnan(x) ? NUMBER_STATUS_NAN_ARGUMENT : 0;
+}
+
+// std::sqrt without errno: NaN for negative arguments.
+double sqrtQuiet(double num)
+{
+	return _mm_cvtsd_f64(_mm_sqrt_sd(_mm_setzero_pd(), _mm_set_sd(num)));
+}
+
+// The flag when any lane of mask is set.
+unsigned flagIf(__m128d mask, unsigned flag)
+{
+	return _mm_movemask_pd(mask) != 0 ? flag : 0;
+}
+
+} // namespace
+
+NumberResult numberDivideChecked(const Number& a, const Number& b)
+{
+	const double x = a.getValue();
+	const double y = b.getValue();
+	return NumberResult{ Number(x / y), divisionStatus(x, y) };
+}
+
+NumberResult numberSqrtChecked(const Number& num)
+{
+	const double x = num.getValue();
+	return NumberResult{ Number(sqrtQuiet(x)), sqrtStatus(x) };
+}
+
+NumberResult numberAtan2Checked(const Number& y, const Number& x)
+{
+	return NumberResult{ Number(std::atan2(y.getValue(), x.getValue())), atan2Status(y.getValue(), x.getValue()) };
+}
+
+unsigned numberDivideArray(const double* a, const double* b, double* out, size_t count)
+{
+	const __m128d zero = _mm_setzero_pd();
+	__m128d byZero = zero;
+	__m128d nan = zero;
+	size_t i = 0;
+	for (; i + 2 <= count; i += 2) {
+		const __m128d x = _mm_loadu_pd(a + i);
+		const __m128d y = _mm_loadu_pd(b + i);
+		byZero = _mm_or_pd(byZero, _mm_cmpeq_pd(y, zero));
+		nan = _mm_or_pd(nan, _mm_cmpunord_pd(x, y));
+		_mm_storeu_pd(out + i, _mm_div_pd(x, y));
+	}
+	unsigned status = flagIf(byZero, NUMBER_STATUS_DIVISION_BY_ZERO) | flagIf(nan, NUMBER_STATUS_NAN_ARGUMENT);
+	for (; i < count; ++i) {
+		status |= divisionStatus(a[i], b[i]);
+		out[i] = a[i] / b[i];
+	}
+	return status;
+}
+
+unsigned numberSqrtArray(const double* in, double* out, size_t count)
+{
+	const __m128d zero = _mm_setzero_pd();
+	__m128d negative = zero;
+	__m128d nan = zero;
+	size_t i = 0;
+	for (; i + 2 <= count; i += 2) {
+		const __m128d x = _mm_loadu_pd(in + i);
+		negative = _mm_or_pd(negative, _mm_cmplt_pd(x, zero));
+		nan = _mm_or_pd(nan, _mm_cmpunord_pd(x, x));
+		_mm_storeu_pd(out + i, _mm_sqrt_pd(x));
+	}
+	unsigned status = flagIf(negative, NUMBER_STATUS_SQRT_OF_NEGATIVE) | flagIf(nan, NUMBER_STATUS_NAN_ARGUMENT);
+	for (; i < count; ++i) {
+		status |= sqrtStatus(in[i]);
+		out[i] = sqrtQuiet(in[i]);
+	}
+	return status;
+}
+
+// atan2 stays a libm call per element; only its check is free of branches.
+unsigned numberAtan2Array(const double* y, const double* x, double* out, size_t count)
+{
+	unsigned status = 0;
+	for (size_t i = 0; i < count; ++i) {
+		const double yi = y[i];
+		const double xi = x[i];
+		status |= atan2Status(yi, xi);
+		out[i] = std::atan2(yi, xi);
+	}
+	return status;
+}
@@ -0,0 +1,42 @@
+#ifndef NUMBER_CHECKED
+#define NUMBER_CHECKED
+
+#include "NumberLibrary.h"
+#include <cstddef>
+
+// Division, sqrt and atan2 that report invalid input with status flags
+// instead of exceptions. The result is always the IEEE one (an infinity or
+// NaN for invalid input) and the flags say what went wrong; the array forms
+// or the flags of all elements together, so a whole batch is checked once
+// at the end. The checks are comparisons folded into the flags, not
+// branches, so the array loops vectorize. The throwing operator/ and
+// numberSqrt of NumberLibrary.h are unchanged.
+
+enum NumberStatus {
+	NUMBER_STATUS_OK = 0,
+	NUMBER_STATUS_DIVISION_BY_ZERO = 1,
+	NUMBER_STATUS_SQRT_OF_NEGATIVE = 2,
+	NUMBER_STATUS_NAN_ARGUMENT = 4
+};
+
+// A value and the NumberStatus flags of the operation that produced it.
+struct NumberResult
+{
+	Number value;
+	unsigned status;
+
+	bool ok() const { return status == NUMBER_STATUS_OK; }
+};
+
+NumberResult numberDivideChecked(const Number& a, const Number& b);
+NumberResult numberSqrtChecked(const Number& num);
+NumberResult numberAtan2Checked(const Number& y, const Number& x);
+
+// out[i] = a[i] / b[i], sqrt(in[i]), atan2(y[i], x[i]) for i < count.
+// Return the NumberStatus flags of all elements or'ed together; out may be
+// one of the inputs.
+unsigned numberDivideArray(const double* a, const double* b, double* out, size_t count);
+unsigned numberSqrtArray(const double* in, double* out, size_t count);
+unsigned numberAtan2Array(const double* y, const double* x, double* out, size_t count);
+
+#endif // NUMBER_CHECKED
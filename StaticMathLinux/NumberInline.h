@@ -0,0 +1,107 @@
+#ifndef NUMBER_INLINE
+#define NUMBER_INLINE
+
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <string>
+
+// Header-only Number: the same class as NumberLibrary.h, but every member is
+// inline, constexpr where C++17 allows and noexcept, so arithmetic compiles
+// to plain double instructions instead of calls into libNumberLibrary.a.
+// It lives in its own namespace so both can be used in one program; the
+// library stays the stable ABI.
+//
+// Being noexcept, the two checks of the library are not made: division by
+// zero gives an infinity or NaN instead of std::runtime_error, and the
+// square root of a negative number gives NaN instead of std::domain_error.
+namespace inline_math {
+
+// As in NumberLibrary.h: the shortest round trip, the six significant
+// digits of toString, and the most format_to ever writes.
+inline constexpr int NUMBER_FORMAT_SHORTEST = -1;
+inline constexpr int NUMBER_FORMAT_TO_STRING = 6;
+inline constexpr size_t NUMBER_FORMAT_MAX = 32;
+
+class Number
+{
+public:
+	constexpr Number() noexcept : _num(0.0) {}
+
+	constexpr explicit Number(double value) noexcept : _num(value) {}
+
+	constexpr Number operator+(const Number& other) const noexcept
+	{
+		return Number(_num + other._num);
+	}
+
+	constexpr Number operator-(const Number& other) const noexcept
+	{
+		return Number(_num - other._num);
+	}
+
+	constexpr Number operator*(const Number& other) const noexcept
+	{
+		return Number(_num * other._num);
+	}
+
+	constexpr Number operator/(const Number& other) const noexcept
+	{
+		return Number(_num / other._num);
+	}
+
+	std::string toString() const
+	{
+		char buffer[NUMBER_FORMAT_MAX];
+		return std::string(buffer, format_to(buffer, sizeof buffer, NUMBER_FORMAT_TO_STRING));
+	}
+
+	// Same text and contract as the library's Number::format_to.
+	size_t format_to(char* buffer, size_t size, int precision = NUMBER_FORMAT_SHORTEST) const noexcept
+	{
+		const std::to_chars_result result = precision < 0
+			? std::to_chars(buffer, buffer + size, _num)
+			: std::to_chars(buffer, buffer + size, _num, std::chars_format::general, precision < 17 ? precision : 17);
+		return result.ec == std::errc() ? size_t(result.ptr - buffer) : 0;
+	}
+
+	void append_to(std::string& out, int precision = NUMBER_FORMAT_SHORTEST) const
+	{
+		const size_t length = out.size();
+		out.resize(length + NUMBER_FORMAT_MAX);
+		out.resize(length + format_to(&out[length], NUMBER_FORMAT_MAX, precision));
+	}
+
+	constexpr double getValue() const noexcept
+	{
+		return _num;
+	}
+
+private:
+	double _num;
+};
+
+inline constexpr Number NUMBER_ZERO(0.0);
+inline constexpr Number NUMBER_ONE(1.0);
+
+// Spelled like the library function, whose first letter is a Cyrillic "с",
+// so that code moves between the two by changing the namespace only.
+constexpr Number сreateNumber(double num) noexcept
+{
+	return Number(num);
+}
+
+// Not constexpr: std::sqrt and std::atan2 are not constexpr in C++17.
+inline Number numberSqrt(const Number& num) noexcept
+{
+	return Number(std::sqrt(num.getValue()));
+}
+
+inline Number numberAtan2(const Number& y, const Number& x) noexcept
+{
+	return Number(std::atan2(y.getValue(), x.getValue()));
+}
+
+} // namespace inline_math
+
+#endif // NUMBER_INLINE
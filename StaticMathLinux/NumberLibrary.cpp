@@ -1,5 +1,5 @@
 #include "NumberLibrary.h"
-#include <sstream>
+#include <charconv>
 #include <stdexcept>
 #include <cmath>
 
@@ -31,9 +31,23 @@ double Number::getValue() const
 }
 
 std::string Number::toString() const {
-	std::ostringstream ss;
-	ss << _num;
-	return ss.str();
+	char buffer[NUMBER_FORMAT_MAX];
+	return std::string(buffer, format_to(buffer, sizeof buffer, NUMBER_FORMAT_TO_STRING));
+}
+
+size_t Number::format_to(char* buffer, size_t size, int precision) const
+{
+	const std::to_chars_result result = precision < 0
+		? std::to_chars(buffer, buffer + size, _num)
+		: std::to_chars(buffer, buffer + size, _num, std::chars_format::general, precision < 17 ? precision : 17);
+	return result.ec == std::errc() ? size_t(result.ptr - buffer) : 0;
+}
+
+void Number::append_to(std::string& out, int precision) const
+{
+	const size_t length = out.size();
+	out.resize(length + NUMBER_FORMAT_MAX);
+	out.resize(length + format_to(&out[length], NUMBER_FORMAT_MAX, precision));
 }
 
 Number сreateNumber(double num)
@@ -1,9 +1,18 @@
 #ifndef NUMBER_LIBRARY
 #define NUMBER_LIBRARY
 
+#include <cstddef>
 #include <iostream>
 #include <string>
 
+// Precision of format_to / append_to: the shortest text that reads back as
+// the same double.
+const int NUMBER_FORMAT_SHORTEST = -1;
+// Precision of toString, six significant digits as std::ostream prints.
+const int NUMBER_FORMAT_TO_STRING = 6;
+// Buffer size that format_to never exceeds.
+const size_t NUMBER_FORMAT_MAX = 32;
+
 class Number
 {
 public:
@@ -21,6 +30,16 @@ public:
 
 	std::string toString() const;
 
+	// Writes the value into buffer without allocating or a terminating zero
+	// and returns the number of characters written, or 0 when size is too
+	// small. A precision of 0 to 17 gives that many significant digits like
+	// printf's %g (above 17 counts as 17); NUMBER_FORMAT_SHORTEST the
+	// shortest round trip.
+	size_t format_to(char* buffer, size_t size, int precision = NUMBER_FORMAT_SHORTEST) const;
+
+	// Appends the text of format_to to out.
+	void append_to(std::string& out, int precision = NUMBER_FORMAT_SHORTEST) const;
+
 	double getValue() const;
 
 private:
@@ -0,0 +1,332 @@
+// Vector rounds every product and sum (each Number operator is a call),
+// so nothing in this file may be contracted into a fused multiply-add or
+// radius would differ from it in the last bit. Set before the includes so
+// the intrinsics are compiled with the same options as their callers.
+#pragma GCC optimize("fp-contract=off")
+
+#include "VectorBatch.h"
+
+#include <immintrin.h>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+// atan(u) = u + u^3 P(u^2) / Q(u^2) for |u| <= 0.66, the Cephes rational
+// approximation. MOREBITS is pi/2 minus its double, added back after the
+// reductions by pi/4, pi/2 and pi.
+const double P0 = -8.750608600031904122785e-01;
+const double P1 = -1.615753718733365076637e+01;
+const double P2 = -7.500855792314704667340e+01;
+const double P3 = -1.228866684490136173410e+02;
+const double P4 = -6.485021904942025371773e+01;
+const double Q0 = 2.485846490142306297962e+01;
+const double Q1 = 1.650270098316988542046e+02;
+const double Q2 = 4.328810604912902668951e+02;
+const double Q3 = 4.853903996359136964868e+02;
+const double Q4 = 1.945506571482613964425e+02;
+const double PI = 3.14159265358979323846;
+const double PIO2 = 1.57079632679489661923;
+const double PIO4 = 0.78539816339744830962;
+const double MOREBITS = 6.123233995736765886130e-17;
+
+// Scalar forms, used where the CPU has no AVX2. They are what Vector
+// computes, so these paths have no error at all.
+void radiusScalar(const double* x, const double* y, double* out, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = std::sqrt(x[i] * x[i] + y[i] * y[i]);
+    }
+}
+
+void angleScalar(const double* x, const double* y, double* out, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = std::atan2(y[i], x[i]);
+    }
+}
+
+void normalizeScalar(double* x, double* y, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        double r = std::sqrt(x[i] * x[i] + y[i] * y[i]);
+        if (r != 0.0) {
+            x[i] = x[i] / r;
+            y[i] = y[i] / r;
+        }
+    }
+}
+
+// atan2 reduces
+// to t = min(|x|, |y|) / max(|x|, |y|) in [0, 1], then to |u| <= 0.2 by
+// atan(t) = pi/4 + atan((t - 1) / (t + 1)) above 0.66, and unfolds the
+// octant from the comparison of |x| and |y| and the signs of x and y.
+
+__attribute__((target("avx2")))
+__m256d atan2Avx2(__m256d y, __m256d x) {
+    const __m256d signBit = _mm256_set1_pd(-0.0);
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d one = _mm256_set1_pd(1.0);
+    __m256d ax = _mm256_andnot_pd(signBit, x);
+    __m256d ay = _mm256_andnot_pd(signBit, y);
+    __m256d swap = _mm256_cmp_pd(ay, ax, _CMP_GT_OQ);
+    __m256d num = _mm256_blendv_pd(ay, ax, swap);
+    __m256d den = _mm256_blendv_pd(ax, ay, swap);
+    __m256d t = _mm256_div_pd(num, den);
+    // inf / inf is atan2(inf, inf) = pi/4; 0 / 0 is atan2(0, 0) = 0.
+    t = _mm256_blendv_pd(t, one, _mm256_cmp_pd(num, _mm256_set1_pd(INFINITY), _CMP_EQ_OQ));
+    t = _mm256_blendv_pd(t, zero, _mm256_cmp_pd(den, zero, _CMP_EQ_OQ));
+
+    __m256d high = _mm256_cmp_pd(t, _mm256_set1_pd(0.66), _CMP_GT_OQ);
+    __m256d u = _mm256_blendv_pd(t, _mm256_div_pd(_mm256_sub_pd(t, one), _mm256_add_pd(t, one)), high);
+    __m256d z = _mm256_mul_pd(u, u);
+    __m256d p = _mm256_add_pd(_mm256_mul_pd(_mm256_set1_pd(P0), z), _mm256_set1_pd(P1));
+    p = _mm256_add_pd(_mm256_mul_pd(p, z), _mm256_set1_pd(P2));
+    p = _mm256_add_pd(_mm256_mul_pd(p, z), _mm256_set1_pd(P3));
+    p = _mm256_add_pd(_mm256_mul_pd(p, z), _mm256_set1_pd(P4));
+    __m256d q = _mm256_add_pd(z, _mm256_set1_pd(Q0));
+    q = _mm256_add_pd(_mm256_mul_pd(q, z), _mm256_set1_pd(Q1));
+    q = _mm256_add_pd(_mm256_mul_pd(q, z), _mm256_set1_pd(Q2));
+    q = _mm256_add_pd(_mm256_mul_pd(q, z), _mm256_set1_pd(Q3));
+    q = _mm256_add_pd(_mm256_mul_pd(q, z), _mm256_set1_pd(Q4));
+    __m256d a = _mm256_add_pd(_mm256_mul_pd(u, _mm256_div_pd(_mm256_mul_pd(z, p), q)), u);
+    a = _mm256_add_pd(_mm256_add_pd(_mm256_and_pd(high, _mm256_set1_pd(PIO4)), a),
+                      _mm256_and_pd(high, _mm256_set1_pd(0.5 * MOREBITS)));
+
+    a = _mm256_blendv_pd(a, _mm256_add_pd(_mm256_sub_pd(_mm256_set1_pd(PIO2), a), _mm256_set1_pd(MOREBITS)), swap);
+    // blendv picks by the sign bit, so x itself selects x < 0 and x = -0.
+    a = _mm256_blendv_pd(a, _mm256_add_pd(_mm256_sub_pd(_mm256_set1_pd(PI), a), _mm256_set1_pd(2.0 * MOREBITS)), x);
+    a = _mm256_or_pd(a, _mm256_and_pd(signBit, y));
+    return _mm256_blendv_pd(a, _mm256_add_pd(x, y), _mm256_cmp_pd(x, y, _CMP_UNORD_Q));
+}
+
+__attribute__((target("avx2")))
+__m256d radiusAvx2(__m256d x, __m256d y) {
+    return _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(x, x), _mm256_mul_pd(y, y)));
+}
+
+struct RadiusAvx2 {
+    __attribute__((target("avx2")))
+    static __m256d apply(__m256d x, __m256d y) { return radiusAvx2(x, y); }
+};
+
+struct AngleAvx2 {
+    __attribute__((target("avx2")))
+    static __m256d apply(__m256d x, __m256d y) { return atan2Avx2(y, x); }
+};
+
+// Runs Op on full groups of four and once more on the zero-padded tail,
+// so every element goes through the same instructions.
+template <typename Op>
+__attribute__((target("avx2")))
+void forEachAvx2(const double* x, const double* y, double* out, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm256_storeu_pd(out + i, Op::apply(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+    }
+    if (i < count) {
+        double tailX[4] = {}, tailY[4] = {}, tailOut[4];
+        for (size_t j = 0; i + j < count; ++j) {
+            tailX[j] = x[i + j];
+            tailY[j] = y[i + j];
+        }
+        _mm256_storeu_pd(tailOut, Op::apply(_mm256_loadu_pd(tailX), _mm256_loadu_pd(tailY)));
+        for (size_t j = 0; i + j < count; ++j) {
+            out[i + j] = tailOut[j];
+        }
+    }
+}
+
+__attribute__((target("avx2")))
+void normalizeAvx2(double* x, double* y, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256d vx = _mm256_loadu_pd(x + i);
+        __m256d vy = _mm256_loadu_pd(y + i);
+        __m256d r = radiusAvx2(vx, vy);
+        __m256d isZero = _mm256_cmp_pd(r, _mm256_setzero_pd(), _CMP_EQ_OQ);
+        _mm256_storeu_pd(x + i, _mm256_blendv_pd(_mm256_div_pd(vx, r), vx, isZero));
+        _mm256_storeu_pd(y + i, _mm256_blendv_pd(_mm256_div_pd(vy, r), vy, isZero));
+    }
+    normalizeScalar(x + i, y + i, count - i);
+}
+
+__attribute__((target("avx512f")))
+__m512d atan2Avx512(__m512d y, __m512d x) {
+    const __m512i signBit = _mm512_set1_epi64(static_cast<long long>(0x8000000000000000ull));
+    const __m512d zero = _mm512_setzero_pd();
+    const __m512d one = _mm512_set1_pd(1.0);
+    __m512d ax = _mm512_abs_pd(x);
+    __m512d ay = _mm512_abs_pd(y);
+    __mmask8 swap = _mm512_cmp_pd_mask(ay, ax, _CMP_GT_OQ);
+    __m512d num = _mm512_mask_blend_pd(swap, ay, ax);
+    __m512d den = _mm512_mask_blend_pd(swap, ax, ay);
+    __m512d t = _mm512_div_pd(num, den);
+    // inf / inf is atan2(inf, inf) = pi/4; 0 / 0 is atan2(0, 0) = 0.
+    t = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(num, _mm512_set1_pd(INFINITY), _CMP_EQ_OQ), t, one);
+    t = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(den, zero, _CMP_EQ_OQ), t, zero);
+
+    __mmask8 high = _mm512_cmp_pd_mask(t, _mm512_set1_pd(0.66), _CMP_GT_OQ);
+    __m512d u = _mm512_mask_div_pd(t, high, _mm512_sub_pd(t, one), _mm512_add_pd(t, one));
+    __m512d z = _mm512_mul_pd(u, u);
+    __m512d p = _mm512_add_pd(_mm512_mul_pd(_mm512_set1_pd(P0), z), _mm512_set1_pd(P1));
+    p = _mm512_add_pd(_mm512_mul_pd(p, z), _mm512_set1_pd(P2));
+    p = _mm512_add_pd(_mm512_mul_pd(p, z), _mm512_set1_pd(P3));
+    p = _mm512_add_pd(_mm512_mul_pd(p, z), _mm512_set1_pd(P4));
+    __m512d q = _mm512_add_pd(z, _mm512_set1_pd(Q0));
+    q = _mm512_add_pd(_mm512_mul_pd(q, z), _mm512_set1_pd(Q1));
+    q = _mm512_add_pd(_mm512_mul_pd(q, z), _mm512_set1_pd(Q2));
+    q = _mm512_add_pd(_mm512_mul_pd(q, z), _mm512_set1_pd(Q3));
+    q = _mm512_add_pd(_mm512_mul_pd(q, z), _mm512_set1_pd(Q4));
+    __m512d a = _mm512_add_pd(_mm512_mul_pd(u, _mm512_div_pd(_mm512_mul_pd(z, p), q)), u);
+    a = _mm512_mask_add_pd(a, high, _mm512_add_pd(_mm512_set1_pd(PIO4), a), _mm512_set1_pd(0.5 * MOREBITS));
+
+    a = _mm512_mask_add_pd(a, swap, _mm512_sub_pd(_mm512_set1_pd(PIO2), a), _mm512_set1_pd(MOREBITS));
+    __mmask8 negativeX = _mm512_cmplt_epi64_mask(_mm512_castpd_si512(x), _mm512_setzero_si512());
+    a = _mm512_mask_add_pd(a, negativeX, _mm512_sub_pd(_mm512_set1_pd(PI), a), _mm512_set1_pd(2.0 * MOREBITS));
+    a = _mm512_castsi512_pd(_mm512_or_si512(_mm512_castpd_si512(a),
+                                            _mm512_and_si512(signBit, _mm512_castpd_si512(y))));
+    return _mm512_mask_add_pd(a, _mm512_cmp_pd_mask(x, y, _CMP_UNORD_Q), x, y);
+}
+
+// The masked sqrt with all lanes set, because GCC 12 warns about the
+// undefined pass-through operand of the plain _mm512_sqrt_pd.
+__attribute__((target("avx512f")))
+__m512d radiusAvx512(__m512d x, __m512d y) {
+    return _mm512_maskz_sqrt_pd(0xff, _mm512_add_pd(_mm512_mul_pd(x, x), _mm512_mul_pd(y, y)));
+}
+
+__attribute__((target("avx512f")))
+void radiusAvx512(const double* x, const double* y, double* out, size_t count) {
+    for (size_t i = 0; i < count; i += 8) {
+        __mmask8 lanes = count - i >= 8 ? 0xff : static_cast<__mmask8>((1u << (count - i)) - 1);
+        __m512d vx = _mm512_maskz_loadu_pd(lanes, x + i);
+        __m512d vy = _mm512_maskz_loadu_pd(lanes, y + i);
+        _mm512_mask_storeu_pd(out + i, lanes, radiusAvx512(vx, vy));
+    }
+}
+
+__attribute__((target("avx512f")))
+void angleAvx512(const double* x, const double* y, double* out, size_t count) {
+    for (size_t i = 0; i < count; i += 8) {
+        __mmask8 lanes = count - i >= 8 ? 0xff : static_cast<__mmask8>((1u << (count - i)) - 1);
+        __m512d vx = _mm512_maskz_loadu_pd(lanes, x + i);
+        __m512d vy = _mm512_maskz_loadu_pd(lanes, y + i);
+        _mm512_mask_storeu_pd(out + i, lanes, atan2Avx512(vy, vx));
+    }
+}
+
+__attribute__((target("avx512f")))
+void normalizeAvx512(double* x, double* y, size_t count) {
+    for (size_t i = 0; i < count; i += 8) {
+        __mmask8 lanes = count - i >= 8 ? 0xff : static_cast<__mmask8>((1u << (count - i)) - 1);
+        __m512d vx = _mm512_maskz_loadu_pd(lanes, x + i);
+        __m512d vy = _mm512_maskz_loadu_pd(lanes, y + i);
+        __m512d r = radiusAvx512(vx, vy);
+        __mmask8 nonZero = _mm512_cmp_pd_mask(r, _mm512_setzero_pd(), _CMP_NEQ_UQ) & lanes;
+        _mm512_mask_storeu_pd(x + i, nonZero, _mm512_div_pd(vx, r));
+        _mm512_mask_storeu_pd(y + i, nonZero, _mm512_div_pd(vy, r));
+    }
+}
+
+struct Kernels {
+    const char* isa;
+    void (*radius)(const double*, const double*, double*, size_t);
+    void (*angle)(const double*, const double*, double*, size_t);
+    void (*normalize)(double*, double*, size_t);
+};
+
+const Kernels& kernels() {
+    static const Kernels selected = [] {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) {
+            return Kernels{ "avx512", radiusAvx512, angleAvx512, normalizeAvx512 };
+        }
+        if (__builtin_cpu_supports("avx2")) {
+            return Kernels{ "avx2", forEachAvx2<RadiusAvx2>, forEachAvx2<AngleAvx2>, normalizeAvx2 };
+        }
+        return Kernels{ "scalar", radiusScalar, angleScalar, normalizeScalar };
+    }();
+    return selected;
+}
+
+} // namespace
+
+VectorBatch::VectorBatch() {}
+VectorBatch::VectorBatch(size_t count) : _x(count), _y(count) {}
+
+size_t VectorBatch::size() const
+{
+    return _x.size();
+}
+
+void VectorBatch::resize(size_t count)
+{
+    _x.resize(count);
+    _y.resize(count);
+}
+
+void VectorBatch::push_back(const Vector& vector)
+{
+    _x.push_back(vector.getX().getValue());
+    _y.push_back(vector.getY().getValue());
+}
+
+Vector VectorBatch::get(size_t index) const
+{
+    return Vector(Number(_x[index]), Number(_y[index]));
+}
+
+void VectorBatch::set(size_t index, const Vector& vector)
+{
+    _x[index] = vector.getX().getValue();
+    _y[index] = vector.getY().getValue();
+}
+
+double* VectorBatch::x() { return _x.data(); }
+double* VectorBatch::y() { return _y.data(); }
+const double* VectorBatch::x() const { return _x.data(); }
+const double* VectorBatch::y() const { return _y.data(); }
+
+void VectorBatch::add(const VectorBatch& other)
+{
+    if (other.size() != size()) throw std::invalid_argument("VectorBatch::add: sizes differ");
+    // Plain loops: the compiler vectorizes them for any target, and an
+    // addition rounds the same in every width.
+    for (size_t i = 0; i < _x.size(); ++i) {
+        _x[i] += other._x[i];
+        _y[i] += other._y[i];
+    }
+}
+
+void VectorBatch::radius(double* out) const
+{
+    kernels().radius(_x.data(), _y.data(), out, size());
+}
+
+void VectorBatch::angle(double* out) const
+{
+    kernels().angle(_x.data(), _y.data(), out, size());
+}
+
+void VectorBatch::normalize()
+{
+    kernels().normalize(_x.data(), _y.data(), size());
+}
+
+void VectorBatch::append_to(std::string& out, char separator, int precision) const
+{
+    const size_t chunk = 4096;
+    for (size_t first = 0; first < size(); first += chunk) {
+        const size_t last = first + chunk < size() ? first + chunk : size();
+        size_t length = out.size();
+        out.resize(length + (last - first) * (VECTOR_FORMAT_MAX + 1));
+        for (size_t i = first; i < last; ++i) {
+            length += Vector(Number(_x[i]), Number(_y[i])).format_to(&out[length], VECTOR_FORMAT_MAX, precision);
+            out[length++] = separator;
+        }
+        out.resize(length);
+    }
+}
+
+const char* VectorBatch::isa()
+{
+    return kernels().isa;
+}
@@ -0,0 +1,63 @@
+#ifndef VECTOR_BATCH
+#define VECTOR_BATCH
+
+#include "VectorDLL.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Worst error of VectorBatch::angle against Vector::angle (std::atan2),
+// in units in the last place of the result, measured over random
+// vectors of all magnitudes and the special values (zeros, infinities).
+// radius, add and normalize round exactly like their scalar forms.
+const int VECTOR_BATCH_ANGLE_MAX_ULP = 2;
+
+// Many 2D vectors stored as structure of arrays: all x components, then
+// all y components, each contiguous. The bulk operations run on AVX-512
+// or AVX2 when the CPU has them and on plain C++ otherwise; isa() tells
+// which.
+class VECTORDLL_API VectorBatch {
+public:
+    VectorBatch();
+    explicit VectorBatch(size_t count);
+
+    size_t size() const;
+    void resize(size_t count);
+    void push_back(const Vector& vector);
+
+    Vector get(size_t index) const;
+    void set(size_t index, const Vector& vector);
+
+    double* x();
+    double* y();
+    const double* x() const;
+    const double* y() const;
+
+    // this[i] = this[i] + other[i]. Throws std::invalid_argument when the
+    // sizes differ.
+    void add(const VectorBatch& other);
+
+    // out[i] = this[i].radius(), bit for bit. out holds size() values.
+    void radius(double* out) const;
+
+    // out[i] = this[i].angle() within VECTOR_BATCH_ANGLE_MAX_ULP. out
+    // holds size() values.
+    void angle(double* out) const;
+
+    // this[i] = this[i] / this[i].radius(). Zero vectors, which Number
+    // division would reject, are left as they are.
+    void normalize();
+
+    // Appends every vector as Vector::append_to does, each followed by
+    // separator, growing out once per few thousand vectors.
+    void append_to(std::string& out, char separator = '\n', int precision = NUMBER_FORMAT_SHORTEST) const;
+
+    // "avx512", "avx2" or "scalar".
+    static const char* isa();
+
+private:
+    std::vector<double> _x;
+    std::vector<double> _y;
+};
+
+#endif // VECTOR_BATCH
@@ -1,8 +1,6 @@
 #include "VectorDLL.h"
 #include "NumberLibrary.h"
 
-#include <sstream>
-
 Vector::Vector() : _x(NUMBER_ZERO), _y(NUMBER_ZERO) {}
 Vector::Vector(const Number& x, const Number& y) : _x(x), _y(y) {}
 
@@ -32,9 +30,35 @@ Number Vector::angle() const {
 }
 
 std::string Vector::toString() const {
-    std::ostringstream ss;
-    ss << "(" << _x.toString() << ", " << _y.toString() << ")";
-    return ss.str();
+    char buffer[VECTOR_FORMAT_MAX];
+    return std::string(buffer, format_to(buffer, sizeof buffer, NUMBER_FORMAT_TO_STRING));
+}
+
+size_t Vector::format_to(char* buffer, size_t size, int precision) const
+{
+    char* const end = buffer + size;
+    char* next = buffer;
+    if (next == end) return 0;
+    *next++ = '(';
+    size_t written = _x.format_to(next, end - next, precision);
+    if (written == 0) return 0;
+    next += written;
+    if (end - next < 2) return 0;
+    *next++ = ',';
+    *next++ = ' ';
+    written = _y.format_to(next, end - next, precision);
+    if (written == 0) return 0;
+    next += written;
+    if (next == end) return 0;
+    *next++ = ')';
+    return next - buffer;
+}
+
+void Vector::append_to(std::string& out, int precision) const
+{
+    const size_t length = out.size();
+    out.resize(length + VECTOR_FORMAT_MAX);
+    out.resize(length + format_to(&out[length], VECTOR_FORMAT_MAX, precision));
 }
 
 VECTORDLL_API const Vector VECTOR_ZERO = Vector(NUMBER_ZERO, NUMBER_ZERO);
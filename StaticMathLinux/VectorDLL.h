@@ -16,8 +16,12 @@
 #endif
 
 #include "NumberLibrary.h"
+#include <cstddef>
 #include <string>
 
+// Buffer size that Vector::format_to never exceeds: "(x, y)".
+const size_t VECTOR_FORMAT_MAX = 2 * NUMBER_FORMAT_MAX + 4;
+
 class VECTORDLL_API Vector {
 public:
     Vector();
@@ -35,6 +39,11 @@ public:
 
     std::string toString() const;
 
+    // "(x, y)" with Number::format_to for both; returns the characters
+    // written, or 0 when size is too small.
+    size_t format_to(char* buffer, size_t size, int precision = NUMBER_FORMAT_SHORTEST) const;
+    void append_to(std::string& out, int precision = NUMBER_FORMAT_SHORTEST) const;
+
 private:
     Number _x;
     Number _y;
@@ -0,0 +1,87 @@
+#ifndef VECTOR_INLINE
+#define VECTOR_INLINE
+
+#include "NumberInline.h"
+#include <string>
+
+// Header-only Vector on top of NumberInline.h; see there. libVector.so and
+// VectorDLL.h are unchanged.
+namespace inline_math {
+
+inline constexpr size_t VECTOR_FORMAT_MAX = 2 * NUMBER_FORMAT_MAX + 4;
+
+class Vector {
+public:
+    constexpr Vector() noexcept : _x(NUMBER_ZERO), _y(NUMBER_ZERO) {}
+
+    constexpr Vector(const Number& x, const Number& y) noexcept : _x(x), _y(y) {}
+
+    constexpr Number getX() const noexcept { return _x; }
+    constexpr Number getY() const noexcept { return _y; }
+
+    constexpr Vector operator+(const Vector& other) const noexcept
+    {
+        return Vector(_x + other._x, _y + other._y);
+    }
+
+    // Where FMA is enabled (-march=native) the compiler may fuse the
+    // multiply-add, which the out-of-line library never does, so the
+    // result can differ from Vector::radius in the last bit.
+    Number radius() const noexcept
+    {
+        Number xsq = _x * _x;
+        Number ysq = _y * _y;
+        Number sum = xsq + ysq;
+        return numberSqrt(sum);
+    }
+
+    Number angle() const noexcept
+    {
+        return numberAtan2(_y, _x);
+    }
+
+    std::string toString() const
+    {
+        char buffer[VECTOR_FORMAT_MAX];
+        return std::string(buffer, format_to(buffer, sizeof buffer, NUMBER_FORMAT_TO_STRING));
+    }
+
+    // "(x, y)", as the library's Vector::format_to.
+    size_t format_to(char* buffer, size_t size, int precision = NUMBER_FORMAT_SHORTEST) const noexcept
+    {
+        char* const end = buffer + size;
+        char* next = buffer;
+        if (next == end) return 0;
+        *next++ = '(';
+        size_t written = _x.format_to(next, end - next, precision);
+        if (written == 0) return 0;
+        next += written;
+        if (end - next < 2) return 0;
+        *next++ = ',';
+        *next++ = ' ';
+        written = _y.format_to(next, end - next, precision);
+        if (written == 0) return 0;
+        next += written;
+        if (next == end) return 0;
+        *next++ = ')';
+        return next - buffer;
+    }
+
+    void append_to(std::string& out, int precision = NUMBER_FORMAT_SHORTEST) const
+    {
+        const size_t length = out.size();
+        out.resize(length + VECTOR_FORMAT_MAX);
+        out.resize(length + format_to(&out[length], VECTOR_FORMAT_MAX, precision));
+    }
+
+private:
+    Number _x;
+    Number _y;
+};
+
+inline constexpr Vector VECTOR_ZERO = Vector(NUMBER_ZERO, NUMBER_ZERO);
+inline constexpr Vector VECTOR_ONE_ONE = Vector(Number(1), Number(1));
+
+} // namespace inline_math
+
+#endif // VECTOR_INLINE
@@ -0,0 +1,346 @@
+#include "AsyncReader.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <sys/uio.h>
+#include <unistd.h>
+#include "ThreadPool.h"
+
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#define HAVE_IO_URING 1
+#else
+#define HAVE_IO_URING 0
+#endif
+
+namespace {
+
+// Reads the rest of a request after a short read; an end of file before
+// length bytes is an error, as the tiled files are never sparse at the end.
+std::string readRemaining(const ReadRequest& request, size_t done) {
+    char* bytes = static_cast<char*>(request.buffer);
+    while (done < request.length) {
+        ssize_t count = ::pread(request.fd, bytes + done, request.length - done, request.offset + done);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count < 0) {
+            return std::strerror(errno);
+        }
+        if (count == 0) {
+            return "unexpected end of file";
+        }
+        done += static_cast<size_t>(count);
+    }
+    return std::string();
+}
+
+std::runtime_error readError(const std::string& what) {
+    return std::runtime_error("async read: " + what);
+}
+
+// Fallback: every request is a task on a small pool running pread.
+class PreadReader : public AsyncReader {
+public:
+    explicit PreadReader(unsigned queueDepth) : _pool(std::min(queueDepth, 4u)) {}
+
+    ~PreadReader() override {
+        // Tasks refer to _batches; let them finish before it goes away.
+        _pool.wait();
+    }
+
+    uint64_t submit(const std::vector<ReadRequest>& batch) override {
+        uint64_t id;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            id = _nextBatch++;
+            _batches[id].remaining = batch.size();
+        }
+        for (const ReadRequest& request : batch) {
+            _pool.submit([this, id, request] {
+                std::string error = readRemaining(request, 0);
+                std::lock_guard<std::mutex> lock(_mutex);
+                Batch& state = _batches[id];
+                if (!error.empty() && state.error.empty()) {
+                    state.error = error;
+                }
+                if (--state.remaining == 0) {
+                    _done.notify_all();
+                }
+            });
+        }
+        return id;
+    }
+
+    void wait(uint64_t batch) override {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _done.wait(lock, [&] { return _batches[batch].remaining == 0; });
+        std::string error = _batches[batch].error;
+        _batches.erase(batch);
+        if (!error.empty()) {
+            throw readError(error);
+        }
+    }
+
+    const char* name() const override { return "pread"; }
+
+private:
+    struct Batch {
+        size_t remaining = 0;
+        std::string error;
+    };
+
+    std::mutex _mutex;
+    std::condition_variable _done;
+    std::map<uint64_t, Batch> _batches;
+    uint64_t _nextBatch = 0;
+    ThreadPool _pool;       // last: its workers stop before the members above go
+};
+
+#if HAVE_IO_URING
+
+int ioUringSetup(unsigned entries, io_uring_params* params) {
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+int ioUringEnter(int ringFd, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+    return static_cast<int>(::syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+// io_uring through the raw system calls (no liburing): one READV per
+// request, completions matched to their batch through user_data.
+class IoUringReader : public AsyncReader {
+public:
+    explicit IoUringReader(unsigned queueDepth) {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        _ringFd = ioUringSetup(std::max(queueDepth, 2u), &params);
+        if (_ringFd < 0) {
+            throw readError(std::string("io_uring_setup: ") + std::strerror(errno));
+        }
+        _sqEntries = params.sq_entries;
+
+        _sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        _cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool singleMap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (singleMap) {
+            _sqRingSize = _cqRingSize = std::max(_sqRingSize, _cqRingSize);
+        }
+        _sqRing = map(_sqRingSize, IORING_OFF_SQ_RING);
+        _cqRing = singleMap ? _sqRing : map(_cqRingSize, IORING_OFF_CQ_RING);
+        _sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        _sqes = static_cast<io_uring_sqe*>(map(_sqesSize, IORING_OFF_SQES));
+
+        char* sq = static_cast<char*>(_sqRing);
+        _sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        _sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        _sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        _sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        char* cq = static_cast<char*>(_cqRing);
+        _cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        _cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        _cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        _cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    }
+
+    ~IoUringReader() override {
+        // Reads still in flight would write into buffers the caller is
+        // about to free.
+        try {
+            while (_inFlight > 0 && reap(1)) {
+            }
+        } catch (const std::exception&) {
+        }
+        unmap();
+    }
+
+    uint64_t submit(const std::vector<ReadRequest>& batch) override {
+        const uint64_t id = _nextBatch++;
+        Batch& state = _batches[id];
+        state.requests = batch;
+        state.iovecs.resize(batch.size());
+        state.remaining = batch.size();
+        for (size_t i = 0; i < batch.size(); ++i) {
+            state.iovecs[i].iov_base = batch[i].buffer;
+            state.iovecs[i].iov_len = batch[i].length;
+        }
+
+        unsigned queued = 0;
+        for (size_t i = 0; i < batch.size(); ++i) {
+            // Make room by submitting what is queued and reaping.
+            while (*_sqTail - __atomic_load_n(_sqHead, __ATOMIC_ACQUIRE) == _sqEntries ||
+                   _inFlight + queued >= _sqEntries) {
+                enter(queued, 1);
+                _inFlight += queued;
+                queued = 0;
+                reap(0);
+            }
+            const unsigned tail = *_sqTail;
+            const unsigned index = tail & _sqMask;
+            io_uring_sqe& sqe = _sqes[index];
+            std::memset(&sqe, 0, sizeof(sqe));
+            sqe.opcode = IORING_OP_READV;
+            sqe.fd = batch[i].fd;
+            sqe.addr = reinterpret_cast<uint64_t>(&state.iovecs[i]);
+            sqe.len = 1;
+            sqe.off = static_cast<uint64_t>(batch[i].offset);
+            sqe.user_data = id << 20 | i;
+            _sqArray[index] = index;
+            __atomic_store_n(_sqTail, tail + 1, __ATOMIC_RELEASE);
+            ++queued;
+        }
+        enter(queued, 0);
+        _inFlight += queued;
+        return id;
+    }
+
+    void wait(uint64_t batch) override {
+        while (_batches[batch].remaining > 0) {
+            reap(1);
+        }
+        std::string error = _batches[batch].error;
+        _batches.erase(batch);
+        if (!error.empty()) {
+            throw readError(error);
+        }
+    }
+
+    const char* name() const override { return "io_uring"; }
+
+private:
+    struct Batch {
+        std::vector<ReadRequest> requests;
+        std::vector<iovec> iovecs;      // read by the kernel until completion
+        size_t remaining = 0;
+        std::string error;
+    };
+
+    void* map(size_t size, off_t offset) {
+        void* pointer = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ringFd, offset);
+        if (pointer == MAP_FAILED) {
+            const std::string error = std::strerror(errno);
+            unmap();
+            throw readError("io_uring mmap: " + error);
+        }
+        return pointer;
+    }
+
+    void unmap() {
+        if (_sqes) {
+            ::munmap(_sqes, _sqesSize);
+        }
+        if (_cqRing && _cqRing != _sqRing) {
+            ::munmap(_cqRing, _cqRingSize);
+        }
+        if (_sqRing) {
+            ::munmap(_sqRing, _sqRingSize);
+        }
+        if (_ringFd >= 0) {
+            ::close(_ringFd);
+        }
+        _sqes = nullptr;
+        _sqRing = _cqRing = nullptr;
+        _ringFd = -1;
+    }
+
+    // Submits toSubmit queued entries and waits for minComplete completions.
+    void enter(unsigned toSubmit, unsigned minComplete) {
+        while (toSubmit > 0 || minComplete > 0) {
+            int result = ioUringEnter(_ringFd, toSubmit, minComplete, minComplete > 0 ? IORING_ENTER_GETEVENTS : 0);
+            if (result < 0 && (errno == EINTR || errno == EAGAIN || errno == EBUSY)) {
+                continue;
+            }
+            if (result < 0) {
+                throw readError(std::string("io_uring_enter: ") + std::strerror(errno));
+            }
+            toSubmit -= std::min<unsigned>(toSubmit, static_cast<unsigned>(result));
+            minComplete = 0;
+        }
+    }
+
+    // Handles every available completion, after waiting for at least
+    // minComplete; returns whether anything was reaped.
+    bool reap(unsigned minComplete) {
+        unsigned head = *_cqHead;
+        if (minComplete > 0 && head == __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE)) {
+            enter(0, minComplete);
+        }
+        const unsigned tail = __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE);
+        const bool any = head != tail;
+        for (; head != tail; ++head) {
+            const io_uring_cqe& cqe = _cqes[head & _cqMask];
+            auto found = _batches.find(cqe.user_data >> 20);
+            if (found != _batches.end()) {
+                Batch& state = found->second;
+                const ReadRequest& request = state.requests[cqe.user_data & 0xfffff];
+                std::string error;
+                if (cqe.res < 0) {
+                    error = std::strerror(-cqe.res);
+                } else if (static_cast<size_t>(cqe.res) < request.length) {
+                    error = readRemaining(request, static_cast<size_t>(cqe.res));
+                }
+                if (!error.empty() && state.error.empty()) {
+                    state.error = error;
+                }
+                --state.remaining;
+            }
+            --_inFlight;
+        }
+        __atomic_store_n(_cqHead, head, __ATOMIC_RELEASE);
+        return any;
+    }
+
+    int _ringFd = -1;
+    unsigned _sqEntries = 0;
+    size_t _sqRingSize = 0;
+    size_t _cqRingSize = 0;
+    size_t _sqesSize = 0;
+    void* _sqRing = nullptr;
+    void* _cqRing = nullptr;
+    io_uring_sqe* _sqes = nullptr;
+    unsigned* _sqHead = nullptr;
+    unsigned* _sqTail = nullptr;
+    unsigned* _sqArray = nullptr;
+    unsigned _sqMask = 0;
+    unsigned* _cqHead = nullptr;
+    unsigned* _cqTail = nullptr;
+    io_uring_cqe* _cqes = nullptr;
+    unsigned _cqMask = 0;
+    unsigned _inFlight = 0;
+    std::map<uint64_t, Batch> _batches;
+    uint64_t _nextBatch = 0;
+};
+
+#endif // HAVE_IO_URING
+
+} // namespace
+
+std::unique_ptr<AsyncReader> createAsyncReader(const std::string& backend, unsigned queueDepth) {
+    if (backend == "pread") {
+        return std::unique_ptr<AsyncReader>(new PreadReader(queueDepth));
+    }
+    if (backend != "io_uring" && backend != "auto") {
+        throw std::invalid_argument("--io: expected auto, io_uring or pread, got '" + backend + "'");
+    }
+#if HAVE_IO_URING
+    try {
+        return std::unique_ptr<AsyncReader>(new IoUringReader(queueDepth));
+    } catch (const std::runtime_error&) {
+        if (backend == "io_uring") {
+            throw;
+        }
+    }
+#else
+    if (backend == "io_uring") {
+        throw readError("io_uring is not available in this build");
+    }
+#endif
+    return std::unique_ptr<AsyncReader>(new PreadReader(queueDepth));
+}
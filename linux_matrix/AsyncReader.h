@@ -0,0 +1,41 @@
+#ifndef ASYNC_READER_H
+#define ASYNC_READER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+struct ReadRequest {
+    int fd;
+    void* buffer;
+    size_t length;
+    off_t offset;
+};
+
+// Reads that run while the caller computes. Requests are submitted in
+// batches; wait() blocks until one batch has been read in full. A reader
+// is driven by a single thread.
+class AsyncReader {
+public:
+    virtual ~AsyncReader() = default;
+
+    // Starts every read of batch and returns an id for wait().
+    virtual uint64_t submit(const std::vector<ReadRequest>& batch) = 0;
+
+    // Blocks until all reads of the batch are complete. Throws
+    // std::runtime_error for a failed read or an unexpected end of file.
+    virtual void wait(uint64_t batch) = 0;
+
+    virtual const char* name() const = 0;
+};
+
+// backend is "io_uring", "pread" or "auto". "auto" uses io_uring when the
+// kernel provides it (and seccomp allows it) and falls back to a pread
+// thread pool otherwise; "io_uring" throws std::runtime_error instead of
+// falling back. queueDepth bounds the reads in flight.
+std::unique_ptr<AsyncReader> createAsyncReader(const std::string& backend, unsigned queueDepth = 16);
+
+#endif // ASYNC_READER_H
@@ -0,0 +1,178 @@
+#include "AutoTuner.h"
+
+#include <unistd.h>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <tuple>
+
+namespace {
+
+int roundUpToPowerOfTwo(int value) {
+    int power = 1;
+    while (power < value) {
+        power *= 2;
+    }
+    return power;
+}
+
+// Value of "name=value" in text, or "" when the token is absent.
+std::string fieldValue(const std::string& text, const std::string& name) {
+    std::istringstream tokens(text);
+    std::string token;
+    while (tokens >> token) {
+        if (token.compare(0, name.size() + 1, name + "=") == 0) {
+            return token.substr(name.size() + 1);
+        }
+    }
+    return std::string();
+}
+
+} // namespace
+
+std::string shapeClass(const TuneShape& shape) {
+    std::ostringstream ss;
+    ss << elementTypeName(shape.type) << " m" << roundUpToPowerOfTwo(shape.m) << " n"
+       << roundUpToPowerOfTwo(shape.n) << " k" << roundUpToPowerOfTwo(shape.k);
+    return ss.str();
+}
+
+bool TunedConfig::operator<(const TunedConfig& other) const {
+    return std::tie(isa, blockSize, threads) < std::tie(other.isa, other.blockSize, other.threads);
+}
+
+std::string TunedConfig::describe() const {
+    return "isa=" + isa + " block=" + std::to_string(blockSize) + " threads=" + std::to_string(threads);
+}
+
+TuneSpace defaultTuneSpace(const TuneShape& shape, std::vector<std::string> isas, unsigned maxThreads) {
+    TuneSpace space;
+    space.isas = std::move(isas);
+    const int largest = std::max({ shape.m, shape.n, shape.k });
+    for (int block = 16; block <= std::min(256, largest); block *= 2) {
+        space.blockSizes.push_back(block);
+    }
+    if (space.blockSizes.empty()) {
+        space.blockSizes.push_back(largest);
+    }
+    for (unsigned threads = 1; threads < maxThreads; threads *= 2) {
+        space.threads.push_back(threads);
+    }
+    space.threads.push_back(std::max(maxThreads, 1u));
+    return space;
+}
+
+TuneResult autoTune(const TuneSpace& space, const std::function<double(const TunedConfig&)>& measure, int budget) {
+    if (space.isas.empty() || space.blockSizes.empty() || space.threads.empty()) {
+        throw std::invalid_argument("autoTune: empty search space");
+    }
+    TuneResult result;
+    std::map<TunedConfig, double> measured;
+    // Measures config unless it already was; false once the budget is spent.
+    auto evaluate = [&](TunedConfig config) {
+        auto found = measured.find(config);
+        if (found == measured.end()) {
+            if (result.evaluations >= budget) {
+                return false;
+            }
+            ++result.evaluations;
+            config.medianNs = measure(config);
+            found = measured.emplace(config, config.medianNs).first;
+        }
+        if (result.best.isa.empty() || found->second < result.best.medianNs) {
+            result.best = config;
+            result.best.medianNs = found->second;
+        }
+        return true;
+    };
+
+    TunedConfig start;
+    start.isa = space.isas.front();
+    start.blockSize = space.blockSizes[space.blockSizes.size() / 2];
+    start.threads = space.threads.back();
+    evaluate(start);
+
+    bool improved = true;
+    while (improved && result.evaluations < budget) {
+        const TunedConfig before = result.best;
+        for (const std::string& isa : space.isas) {
+            TunedConfig candidate = result.best;
+            candidate.isa = isa;
+            evaluate(candidate);
+        }
+        for (int blockSize : space.blockSizes) {
+            TunedConfig candidate = result.best;
+            candidate.blockSize = blockSize;
+            evaluate(candidate);
+        }
+        for (unsigned threads : space.threads) {
+            TunedConfig candidate = result.best;
+            candidate.threads = threads;
+            evaluate(candidate);
+        }
+        improved = before < result.best || result.best < before;
+    }
+    return result;
+}
+
+TuningDatabase::TuningDatabase(std::string path) : _path(std::move(path)) {
+    std::ifstream in(_path);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        const size_t fields = line.find(" isa=");
+        if (fields == std::string::npos) {
+            continue;
+        }
+        TunedConfig config;
+        config.isa = fieldValue(line, "isa");
+        try {
+            config.blockSize = std::stoi(fieldValue(line, "block"));
+            config.threads = static_cast<unsigned>(std::stoul(fieldValue(line, "threads")));
+            config.medianNs = std::stod(fieldValue(line, "median_ns"));
+        } catch (const std::exception&) {
+            continue;
+        }
+        if (!config.isa.empty() && config.blockSize > 0 && config.threads > 0) {
+            _entries[line.substr(0, fields)] = config;
+        }
+    }
+}
+
+bool TuningDatabase::find(const std::string& shapeClass, TunedConfig& config) const {
+    auto found = _entries.find(shapeClass);
+    if (found == _entries.end()) {
+        return false;
+    }
+    config = found->second;
+    return true;
+}
+
+void TuningDatabase::store(const std::string& shapeClass, const TunedConfig& config) {
+    _entries[shapeClass] = config;
+}
+
+void TuningDatabase::save() const {
+    const std::string temporary = _path + ".tmp." + std::to_string(::getpid());
+    {
+        std::ofstream out(temporary);
+        out << "# matrix benchmark tuning database: <dtype> m<M> n<N> k<K> (dimensions rounded up to\n"
+            << "# powers of two) -> fastest packed configuration measured on this machine\n";
+        for (const auto& entry : _entries) {
+            out << entry.first << " " << entry.second.describe() << " median_ns="
+                << static_cast<long long>(entry.second.medianNs) << "\n";
+        }
+        if (!out.flush()) {
+            std::remove(temporary.c_str());
+            throw std::runtime_error("cannot write tuning database " + temporary);
+        }
+    }
+    if (std::rename(temporary.c_str(), _path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        throw std::runtime_error("cannot replace tuning database " + _path);
+    }
+}
@@ -0,0 +1,80 @@
+#ifndef AUTO_TUNER_H
+#define AUTO_TUNER_H
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+#include "ElementType.h"
+
+// A multiplication C (m x n) = A (m x k) * B (k x n) of one element type.
+struct TuneShape {
+    ElementType type;
+    int m;
+    int n;
+    int k;
+};
+
+// Shapes whose dimensions round up to the same powers of two share a
+// configuration: "<dtype> m<M> n<N> k<K>", e.g. "float m512 n256 k512" for
+// a 300 x 500 by 500 x 200 product.
+std::string shapeClass(const TuneShape& shape);
+
+// One point of the search space of the packed blocked multiply.
+struct TunedConfig {
+    std::string isa;            // GemmKernel::name
+    int blockSize = 0;
+    unsigned threads = 0;
+    double medianNs = 0.0;      // measured when the configuration won
+
+    bool operator<(const TunedConfig& other) const;
+    std::string describe() const;   // "isa= block= threads="
+};
+
+struct TuneSpace {
+    std::vector<std::string> isas;
+    std::vector<int> blockSizes;        // ascending
+    std::vector<unsigned> threads;      // ascending
+};
+
+// Powers of two from 16 up to min(256, the largest dimension), plus the
+// thread counts 1, 2, 4, ... up to and including maxThreads.
+TuneSpace defaultTuneSpace(const TuneShape& shape, std::vector<std::string> isas, unsigned maxThreads);
+
+struct TuneResult {
+    TunedConfig best;
+    int evaluations = 0;
+};
+
+// Coordinate search: starting from the middle block size, the most threads
+// and the first ISA, sweeps one dimension at a time with the others held at
+// the best point so far, until a full round changes nothing or budget
+// configurations have been measured. measure returns the median ns of a
+// configuration; each point is measured at most once. Costs
+// O(|isas| + |blocks| + |threads|) per round instead of the product.
+TuneResult autoTune(const TuneSpace& space, const std::function<double(const TunedConfig&)>& measure, int budget);
+
+// Text file of tuned configurations, one line per shape class:
+//   <shapeClass> isa=<name> block=<k> threads=<t> median_ns=<ns>
+// Lines starting with '#' and lines that do not parse are ignored, so a
+// hand-edited file degrades to re-tuning the affected shapes.
+class TuningDatabase {
+public:
+    // Reads path if it exists; a missing file is an empty database.
+    explicit TuningDatabase(std::string path);
+
+    const std::string& path() const { return _path; }
+
+    bool find(const std::string& shapeClass, TunedConfig& config) const;
+    void store(const std::string& shapeClass, const TunedConfig& config);
+
+    // Writes every entry under a temporary name and renames it into place.
+    // Throws std::runtime_error when the file cannot be written.
+    void save() const;
+
+private:
+    std::string _path;
+    std::map<std::string, TunedConfig> _entries;
+};
+
+#endif // AUTO_TUNER_H
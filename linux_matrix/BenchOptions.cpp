@@ -0,0 +1,334 @@
+#include "BenchOptions.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include "Trace.h"
+
+namespace {
+
+const char* const knownAlgorithms[] = { "naive", "mutex", "owner", "reduce", "packed", "steal", "goto", "strassen", "ooc", "tuned",
+                                      "gemm", "batched" };
+const char* const knownBackends[] = { "pool", "pthread", "thread" };
+
+// Returns the text after "--name=" or nullptr when arg is another option.
+const char* optionValue(const char* arg, const char* name) {
+    size_t length = std::strlen(name);
+    if (std::strncmp(arg, name, length) != 0 || arg[length] != '=') {
+        return nullptr;
+    }
+    return arg + length + 1;
+}
+
+std::vector<std::string> splitList(const std::string& text) {
+    std::vector<std::string> items;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+long long parseInteger(const std::string& text, const char* option, long long minValue) {
+    size_t used = 0;
+    long long value = 0;
+    try {
+        value = std::stoll(text, &used);
+    } catch (const std::exception&) {
+        used = 0;
+    }
+    if (used != text.size() || value < minValue) {
+        throw std::invalid_argument(std::string(option) + ": expected an integer >= " +
+                                    std::to_string(minValue) + ", got '" + text + "'");
+    }
+    return value;
+}
+
+template <typename T>
+std::vector<T> parseIntegerList(const std::string& text, const char* option, long long minValue) {
+    std::vector<T> values;
+    for (const std::string& item : splitList(text)) {
+        values.push_back(static_cast<T>(parseInteger(item, option, minValue)));
+    }
+    if (values.empty()) {
+        throw std::invalid_argument(std::string(option) + ": empty list");
+    }
+    return values;
+}
+
+// "AxBxC" with count positive integers.
+std::vector<int> parseDimensions(const std::string& text, const char* option, size_t count) {
+    std::vector<int> dimensions;
+    size_t start = 0;
+    while (true) {
+        const size_t end = text.find('x', start);
+        dimensions.push_back(static_cast<int>(parseInteger(text.substr(start, end - start), option, 1)));
+        if (end == std::string::npos) {
+            break;
+        }
+        start = end + 1;
+    }
+    if (dimensions.size() != count) {
+        throw std::invalid_argument(std::string(option) + ": expected " + std::to_string(count) +
+                                    " dimensions separated by 'x', got '" + text + "'");
+    }
+    return dimensions;
+}
+
+} // namespace
+
+BenchOptions parseBenchOptions(int argc, char** argv) {
+    BenchOptions options;
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* value = nullptr;
+        if (std::strcmp(arg, "--help") == 0 || std::strcmp(arg, "-h") == 0) {
+            options.help = true;
+        } else if ((value = optionValue(arg, "--sizes"))) {
+            options.sizes = parseIntegerList<int>(value, "--sizes", 1);
+        } else if ((value = optionValue(arg, "--threads"))) {
+            options.threads = parseIntegerList<unsigned>(value, "--threads", 0);
+        } else if ((value = optionValue(arg, "--blocks"))) {
+            options.allBlockSizes = std::strcmp(value, "all") == 0;
+            options.blockSizes.clear();
+            if (!options.allBlockSizes) {
+                options.blockSizes = parseIntegerList<int>(value, "--blocks", 1);
+            }
+        } else if ((value = optionValue(arg, "--algo"))) {
+            options.algorithms = splitList(value);
+            for (const std::string& name : options.algorithms) {
+                if (std::find(std::begin(knownAlgorithms), std::end(knownAlgorithms), name) == std::end(knownAlgorithms)) {
+                    throw std::invalid_argument("--algo: unknown algorithm '" + name + "'");
+                }
+            }
+        } else if ((value = optionValue(arg, "--isa"))) {
+            options.isa = value;
+        } else if ((value = optionValue(arg, "--dtype"))) {
+            options.elementTypes.clear();
+            for (const std::string& name : splitList(value)) {
+                options.elementTypes.push_back(parseElementType(name));
+            }
+            if (options.elementTypes.empty()) {
+                throw std::invalid_argument("--dtype: empty list");
+            }
+        } else if ((value = optionValue(arg, "--warmup"))) {
+            options.warmup = static_cast<int>(parseInteger(value, "--warmup", 0));
+        } else if ((value = optionValue(arg, "--reps"))) {
+            options.repetitions = static_cast<int>(parseInteger(value, "--reps", 1));
+        } else if ((value = optionValue(arg, "--mc"))) {
+            options.mc = static_cast<int>(parseInteger(value, "--mc", 1));
+        } else if ((value = optionValue(arg, "--kc"))) {
+            options.kc = static_cast<int>(parseInteger(value, "--kc", 1));
+        } else if ((value = optionValue(arg, "--nc"))) {
+            options.nc = static_cast<int>(parseInteger(value, "--nc", 1));
+        } else if ((value = optionValue(arg, "--cutoffs"))) {
+            options.cutoffs = parseIntegerList<int>(value, "--cutoffs", 1);
+        } else if ((value = optionValue(arg, "--report"))) {
+            options.reportFormat = value;
+            if (options.reportFormat != "json" && options.reportFormat != "csv") {
+                throw std::invalid_argument("--report: expected json or csv, got '" + options.reportFormat + "'");
+            }
+        } else if ((value = optionValue(arg, "--output"))) {
+            options.reportPath = value;
+        } else if ((value = optionValue(arg, "--compare"))) {
+            options.comparePath = value;
+        } else if (std::strcmp(arg, "--compare") == 0 && i + 1 < argc) {
+            options.comparePath = argv[++i];
+        } else if ((value = optionValue(arg, "--placement"))) {
+            options.placement = parsePlacement(value);
+        } else if ((value = optionValue(arg, "--seed"))) {
+            options.seed = static_cast<uint64_t>(parseInteger(value, "--seed", 1));
+        } else if ((value = optionValue(arg, "--verify"))) {
+            options.verify = value;
+            if (options.verify != "full" && options.verify != "freivalds") {
+                throw std::invalid_argument("--verify: expected full or freivalds, got '" + options.verify + "'");
+            }
+        } else if ((value = optionValue(arg, "--trials"))) {
+            options.trials = static_cast<int>(parseInteger(value, "--trials", 1));
+        } else if ((value = optionValue(arg, "--cache-dir"))) {
+            options.cacheDir = value;
+        } else if ((value = optionValue(arg, "--ooc-tile"))) {
+            options.oocTile = static_cast<int>(parseInteger(value, "--ooc-tile", 1));
+        } else if ((value = optionValue(arg, "--ooc-dir"))) {
+            options.oocDir = value;
+        } else if ((value = optionValue(arg, "--ooc-multiply"))) {
+            options.oocMultiply = splitList(value);
+            if (options.oocMultiply.size() != 3) {
+                throw std::invalid_argument(std::string("--ooc-multiply: expected A,B,C, got '") + value + "'");
+            }
+        } else if ((value = optionValue(arg, "--ooc-generate"))) {
+            options.oocGenerate = value;
+        } else if ((value = optionValue(arg, "--ooc-prefetch"))) {
+            options.oocPrefetch = static_cast<int>(parseInteger(value, "--ooc-prefetch", 1));
+        } else if ((value = optionValue(arg, "--io"))) {
+            options.io = value;
+            if (options.io != "auto" && options.io != "io_uring" && options.io != "pread") {
+                throw std::invalid_argument("--io: expected auto, io_uring or pread, got '" + options.io + "'");
+            }
+        } else if ((value = optionValue(arg, "--perf"))) {
+            options.perf = value;
+            if (options.perf != "off" && options.perf != "run" && options.perf != "threads") {
+                throw std::invalid_argument("--perf: expected off, run or threads, got '" + options.perf + "'");
+            }
+        } else if ((value = optionValue(arg, "--trace"))) {
+            if (!tracingCompiledIn) {
+                throw std::invalid_argument("--trace: this build has no tracing, rebuild with -DMATRIX_TRACE=1");
+            }
+            options.tracePath = value;
+        } else if ((value = optionValue(arg, "--tune-db"))) {
+            options.tuneDb = value;
+        } else if ((value = optionValue(arg, "--tune-budget"))) {
+            options.tuneBudget = static_cast<int>(parseInteger(value, "--tune-budget", 1));
+        } else if (std::strcmp(arg, "--retune") == 0) {
+            options.retune = true;
+        } else if ((value = optionValue(arg, "--backends"))) {
+            options.backends = splitList(value);
+            for (const std::string& name : options.backends) {
+                if (std::find(std::begin(knownBackends), std::end(knownBackends), name) == std::end(knownBackends)) {
+                    throw std::invalid_argument("--backends: unknown backend '" + name + "'");
+                }
+            }
+            if (options.backends.empty()) {
+                throw std::invalid_argument("--backends: empty list");
+            }
+        } else if ((value = optionValue(arg, "--gemm-shapes"))) {
+            options.gemmShapes.clear();
+            for (const std::string& item : splitList(value)) {
+                const std::vector<int> d = parseDimensions(item, "--gemm-shapes", 3);
+                options.gemmShapes.push_back({ d[0], d[1], d[2] });
+            }
+            if (options.gemmShapes.empty()) {
+                throw std::invalid_argument("--gemm-shapes: empty list");
+            }
+        } else if ((value = optionValue(arg, "--batches"))) {
+            options.batches.clear();
+            for (const std::string& item : splitList(value)) {
+                const std::vector<int> d = parseDimensions(item, "--batches", 2);
+                options.batches.push_back({ d[0], d[1] });
+            }
+            if (options.batches.empty()) {
+                throw std::invalid_argument("--batches: empty list");
+            }
+        } else if ((value = optionValue(arg, "--threshold"))) {
+            char* end = nullptr;
+            options.regressionThreshold = std::strtod(value, &end);
+            if (end == value || *end != '\0' || options.regressionThreshold < 0.0) {
+                throw std::invalid_argument(std::string("--threshold: expected a percentage, got '") + value + "'");
+            }
+        } else {
+            throw std::invalid_argument(std::string("unknown option '") + arg + "'");
+        }
+    }
+    return options;
+}
+
+void printBenchUsage(std::ostream& out, const char* program) {
+    out << "Usage: " << program << " [options]\n"
+        << "  --sizes=N[,N...]     matrix sizes (default 32)\n"
+        << "  --threads=T[,T...]   worker counts, 0 = one per CPU (default 0)\n"
+        << "  --blocks=K[,K...]    block sizes for mutex/owner/reduce/packed/steal, or 'all' for 1..N\n"
+        << "                       (default 16,32,64,128 clipped to N)\n"
+        << "  --algo=A[,A...]      naive,mutex,owner,reduce,packed,steal,goto,strassen,ooc,\n"
+        << "                       tuned,gemm,batched (default all but ooc, tuned, gemm and batched)\n"
+        << "  --isa=NAME           scalar, sse4.1, avx2, avx512, auto or all (default auto)\n"
+        << "  --backends=B[,B...]  threads of mutex/owner/reduce/packed: pool (persistent pthread\n"
+        << "                       workers), pthread or thread (a pthread / std::thread per task)\n"
+        << "                       (default pool)\n"
+        << "  --dtype=D[,D...]     element types: int64 (int32 inputs, int64 results), int32\n"
+        << "                       (int32 results, wrap past 2^31), float, double (default int64)\n"
+        << "  --warmup=W           untimed runs per configuration (default 1)\n"
+        << "  --reps=R             timed runs per configuration (default 5)\n"
+        << "  --mc= --kc= --nc=    override the cache blocking of goto\n"
+        << "  --cutoffs=C[,C...]   strassen leaf sizes to sweep (default 64,128,256); compare\n"
+        << "                       speedup_vs_goto across sizes to find the crossover\n"
+        << "  --report=json|csv    also write a machine-readable report\n"
+        << "  --output=FILE        report path (default matrix_report.json / .csv)\n"
+        << "  --compare FILE       compare medians with a baseline JSON report and exit\n"
+        << "                       non-zero when a configuration regressed\n"
+        << "  --threshold=PCT      allowed slowdown for --compare (default 5)\n"
+        << "  --placement=P        pin workers: none, compact, scatter or a CPU list like 0,2,4-7;\n"
+        << "                       inputs are then first-touched by the pinned workers (default none)\n"
+        << "  --seed=S             seed of the input matrices; the same seed gives the same inputs\n"
+        << "                       for any thread count (default: random, printed at start)\n"
+        << "  --verify=full|freivalds\n"
+        << "                       check results against a naive reference product, or with\n"
+        << "                       Freivalds' O(n^2) randomized test (default full)\n"
+        << "  --trials=T           Freivalds vectors per check; a wrong result passes with\n"
+        << "                       probability at most 2^-T (default 2)\n"
+        << "  --cache-dir=DIR      keep inputs and the reference product in DIR, keyed by dtype,\n"
+        << "                       size and seed; use with --seed so later runs can reuse them\n"
+        << "  --ooc-tile=T         tile size of the out-of-core files (default 512)\n"
+        << "  --ooc-dir=DIR        where the ooc algorithm writes its tiled files (default .)\n"
+        << "  --ooc-multiply=A,B,C multiply the tiled files A and B out of core into a new file C\n"
+        << "                       with the first --threads value and --isa, then exit\n"
+        << "  --ooc-generate=FILE  write a random --sizes x --sizes tiled matrix of the first --dtype\n"
+        << "                       from --seed (use a different seed per operand), then exit\n"
+        << "  --ooc-prefetch=D     out-of-core steps whose tiles are read ahead (default 2)\n"
+        << "  --io=BACKEND         tile reads: io_uring, pread or auto (io_uring when the kernel\n"
+        << "                       allows it, default)\n"
+        << "  --perf=MODE          hardware counters per run (cycles, instructions, IPC, L1D/LLC\n"
+        << "                       and branch misses per kFLOP): off (default), run, or threads to\n"
+        << "                       also print them per worker thread\n"
+        << "  --trace=FILE         write tasks, lock waits and queue waits of every thread as\n"
+        << "                       Chrome trace JSON for Perfetto (builds with -DMATRIX_TRACE=1)\n"
+        << "  --tune-db=FILE       where the tuned algorithm keeps the fastest micro-kernel, block\n"
+        << "                       size and thread count per shape class (default matrix_tuning.db)\n"
+        << "  --tune-budget=N      configurations the tuner measures for a new shape (default 16)\n"
+        << "  --retune             search again even when the database has the shape\n"
+        << "  --gemm-shapes=MxNxK[,...]\n"
+        << "                       rectangular products of the gemm algorithm\n"
+        << "                       (default 16384x64x64,16384x16x256,64x64x16384)\n"
+        << "  --batches=COUNTxS[,...]\n"
+        << "                       COUNT independent S x S products of the batched algorithm, which\n"
+        << "                       also reports speedup_vs_loop over calling gemm per product\n"
+        << "                       (default 4096x8,4096x16,1024x32,256x64)\n";
+}
+
+std::vector<int> blockSizesFor(const BenchOptions& options, int size) {
+    std::vector<int> result;
+    if (options.allBlockSizes) {
+        for (int blockSize = 1; blockSize <= size; ++blockSize) {
+            result.push_back(blockSize);
+        }
+        return result;
+    }
+    std::vector<int> requested = options.blockSizes;
+    if (requested.empty()) {
+        requested = { 16, 32, 64, 128 };
+    }
+    for (int blockSize : requested) {
+        int clipped = std::min(blockSize, size);
+        if (std::find(result.begin(), result.end(), clipped) == result.end()) {
+            result.push_back(clipped);
+        }
+    }
+    return result;
+}
+
+TimingStats summarizeTimings(std::vector<long long> samplesNs) {
+    TimingStats stats = { 0.0, 0.0, 0.0 };
+    if (samplesNs.empty()) {
+        return stats;
+    }
+    std::sort(samplesNs.begin(), samplesNs.end());
+    const size_t count = samplesNs.size();
+    stats.minNs = static_cast<double>(samplesNs.front());
+    stats.medianNs = count % 2 == 1
+        ? static_cast<double>(samplesNs[count / 2])
+        : (samplesNs[count / 2 - 1] + samplesNs[count / 2]) / 2.0;
+    // Nearest-rank percentile.
+    size_t rank = static_cast<size_t>(std::ceil(0.95 * count));
+    stats.p95Ns = static_cast<double>(samplesNs[std::max<size_t>(rank, 1) - 1]);
+    return stats;
+}
+
+double gigaOpsPerSecond(long long m, long long n, long long k, double ns) {
+    return ns > 0.0 ? 2.0 * m * n * k / ns : 0.0;
+}
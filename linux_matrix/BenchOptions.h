@@ -0,0 +1,86 @@
+#ifndef BENCH_OPTIONS
+#define BENCH_OPTIONS
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include "ElementType.h"
+#include "Topology.h"
+
+// A rectangular product C (m x n) = A (m x k) * B (k x n) for --gemm-shapes.
+struct GemmShape {
+    int m;
+    int n;
+    int k;
+};
+
+// count independent size x size products for --batches.
+struct BatchShape {
+    int count;
+    int size;
+};
+
+// Command line of the matrix benchmark. List options take comma separated
+// values, e.g. --sizes=256,512 --threads=1,4 --blocks=32,64.
+struct BenchOptions {
+    std::vector<int> sizes = { 32 };
+    std::vector<unsigned> threads = { 0 };      // 0 = one per online CPU
+    std::vector<int> blockSizes;                // empty = default list per size
+    bool allBlockSizes = false;                 // --blocks=all: every k in 1..size
+    std::vector<std::string> algorithms = { "naive", "mutex", "owner", "reduce", "packed", "steal", "goto", "strassen" };
+    std::string isa = "auto";                   // micro-kernel, or "all"
+    std::vector<std::string> backends = { "pool" };     // threads of mutex/owner/reduce/packed
+    std::vector<ElementType> elementTypes = { ElementType::Int64 };
+    int warmup = 1;
+    int repetitions = 5;
+    int mc = 0;                                 // 0 = derived from cache sizes
+    int kc = 0;
+    int nc = 0;
+    std::vector<int> cutoffs = { 64, 128, 256 };    // strassen: leaf size below which it stops recursing
+    std::string reportFormat;                   // "", "json" or "csv"
+    std::string reportPath;                     // default matrix_report.<format>
+    std::string comparePath;                    // baseline JSON for --compare
+    double regressionThreshold = 5.0;           // percent
+    Placement placement;                        // worker pinning, default none
+    uint64_t seed = 0;                          // inputs; 0 = pick one from std::random_device
+    std::string verify = "full";                // "full" (naive reference) or "freivalds"
+    int trials = 2;                             // Freivalds vectors per check
+    std::string cacheDir;                       // inputs/reference cache, "" = off
+    int oocTile = 512;                          // tile size of the ooc algorithm and --ooc-generate
+    std::string oocDir = ".";                   // scratch files of the ooc algorithm
+    std::vector<std::string> oocMultiply;       // A, B, C tiled files: multiply and exit
+    std::string oocGenerate;                    // write a random tiled file and exit
+    std::string io = "auto";                    // tile reads: auto, io_uring or pread
+    int oocPrefetch = 2;                        // steps whose tiles are read ahead
+    std::string perf = "off";                   // hardware counters: off, run or threads
+    std::string tracePath;                      // Chrome trace JSON, "" = off (needs MATRIX_TRACE)
+    std::string tuneDb = "matrix_tuning.db";    // tuned algorithm: configurations per shape class
+    int tuneBudget = 16;                        // configurations measured per tuning search
+    bool retune = false;                        // search even when the database has the shape
+    std::vector<GemmShape> gemmShapes = { { 16384, 64, 64 }, { 16384, 16, 256 }, { 64, 64, 16384 } };
+    std::vector<BatchShape> batches = { { 4096, 8 }, { 4096, 16 }, { 1024, 32 }, { 256, 64 } };
+    bool help = false;
+};
+
+// Throws std::invalid_argument describing the first bad argument.
+BenchOptions parseBenchOptions(int argc, char** argv);
+
+void printBenchUsage(std::ostream& out, const char* program);
+
+// Block sizes to sweep for one matrix size.
+std::vector<int> blockSizesFor(const BenchOptions& options, int size);
+
+struct TimingStats {
+    double medianNs;
+    double minNs;
+    double p95Ns;
+};
+
+TimingStats summarizeTimings(std::vector<long long> samplesNs);
+
+// Integer (or floating point) operations per second for an m x k by k x n
+// product, in units of 10^9.
+double gigaOpsPerSecond(long long m, long long n, long long k, double ns);
+
+#endif // BENCH_OPTIONS
@@ -0,0 +1,368 @@
+#include "BlockedMultiply.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include "ThreadSpawner.h"
+#include "Trace.h"
+
+const char* scheduleModeName(ScheduleMode mode) {
+    switch (mode) {
+    case ScheduleMode::Mutex: return "mutex";
+    case ScheduleMode::OwnerTile: return "owner";
+    case ScheduleMode::Reduce: return "reduce";
+    case ScheduleMode::Packed: return "packed";
+    }
+    return "?";
+}
+
+bool parseScheduleMode(const std::string& name, ScheduleMode& mode) {
+    const ScheduleMode modes[] = { ScheduleMode::Mutex, ScheduleMode::OwnerTile, ScheduleMode::Reduce, ScheduleMode::Packed };
+    for (ScheduleMode candidate : modes) {
+        if (name == scheduleModeName(candidate)) {
+            mode = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+template <typename T, typename Acc>
+void naiveProduct(MatrixView<const T> matrixA, MatrixView<const T> matrixB, MatrixView<Acc> resultMatrix) {
+    for (size_t i = 0; i < matrixA.rows(); ++i) {
+        for (size_t j = 0; j < matrixB.cols(); ++j) {
+            Acc sum = Acc();
+            for (size_t k = 0; k < matrixA.cols(); ++k) {
+                sum += static_cast<Acc>(matrixA(i, k)) * static_cast<Acc>(matrixB(k, j));
+            }
+            resultMatrix(i, j) = sum;
+        }
+    }
+}
+
+template <typename T, typename Acc>
+long long multiplyNaive(const Matrix<T>& matrixA, const Matrix<T>& matrixB, Matrix<Acc>& resultMatrix) {
+    auto startTime = std::chrono::steady_clock::now();
+
+    naiveProduct<T, Acc>(matrixA.view(), matrixB.view(), resultMatrix.view());
+
+    auto endTime = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+}
+
+namespace {
+
+std::mutex resultMutex;
+
+// T is the element type of A and B, Acc the type of C (see ElementType.h).
+template <typename T, typename Acc>
+struct BlockArgs {
+    const Matrix<T>* matrixA;
+    const Matrix<T>* matrixB;
+    Matrix<Acc>* resultMatrix;
+    std::vector<Matrix<Acc>>* partialResults;
+    const GemmKernel<T, Acc>* kernel;
+    int blockRowA, blockColA, blockRowB, blockColB, blockSize;
+};
+
+// tileC += tileA * tileB. The i-k-j order streams rows of B and C with
+// unit stride so the innermost loop vectorizes.
+template <typename T, typename Acc>
+void accumulateTile(MatrixView<const T> tileA, MatrixView<const T> tileB, MatrixView<Acc> tileC) {
+    for (size_t i = 0; i < tileC.rows(); ++i) {
+        Acc* rowC = tileC.row(i);
+        const T* rowA = tileA.row(i);
+        for (size_t k = 0; k < tileA.cols(); ++k) {
+            const Acc valueA = rowA[k];
+            const T* rowB = tileB.row(k);
+            for (size_t j = 0; j < tileC.cols(); ++j) {
+                rowC[j] += valueA * static_cast<Acc>(rowB[j]);
+            }
+        }
+    }
+}
+
+template <typename T>
+MatrixView<const T> tileOf(const Matrix<T>& matrix, int blockRow, int blockCol, int blockSize) {
+    return matrix.tile(static_cast<size_t>(blockRow) * blockSize, static_cast<size_t>(blockCol) * blockSize,
+                       blockSize, blockSize);
+}
+
+template <typename T>
+MatrixView<T> tileOf(Matrix<T>& matrix, int blockRow, int blockCol, int blockSize) {
+    return matrix.tile(static_cast<size_t>(blockRow) * blockSize, static_cast<size_t>(blockCol) * blockSize,
+                       blockSize, blockSize);
+}
+
+template <typename T, typename Acc>
+void multiplyBlockWorker(const BlockArgs<T, Acc>* args) {
+    TRACE_SCOPE("task", "mutex block", args->blockRowA, args->blockColB, args->blockColA);
+    MatrixView<const T> tileA = tileOf(*args->matrixA, args->blockRowA, args->blockColA, args->blockSize);
+    MatrixView<const T> tileB = tileOf(*args->matrixB, args->blockRowB, args->blockColB, args->blockSize);
+    MatrixView<Acc> tileC = tileOf(*args->resultMatrix, args->blockRowA, args->blockColB, args->blockSize);
+
+    // One dot product per element into a scalar, then the lock, as the
+    // original baseline did: no scratch tile in the timed region.
+    for (size_t i = 0; i < tileC.rows(); ++i) {
+        for (size_t j = 0; j < tileC.cols(); ++j) {
+            Acc sum = 0;
+            for (size_t k = 0; k < tileA.cols(); ++k) {
+                sum += static_cast<Acc>(tileA(i, k)) * static_cast<Acc>(tileB(k, j));
+            }
+            lockTraced(resultMutex, "resultMutex wait");
+            std::lock_guard<std::mutex> lock(resultMutex, std::adopt_lock);
+            tileC(i, j) += sum;
+        }
+    }
+}
+
+template <typename T, typename Acc>
+void multiplyTileWorker(const BlockArgs<T, Acc>* args) {
+    TRACE_SCOPE("task", "owner tile", args->blockRowA, args->blockColB);
+    int size = args->matrixA->rows();
+    int blocksPerDim = (size + args->blockSize - 1) / args->blockSize;
+    MatrixView<Acc> tileC = tileOf(*args->resultMatrix, args->blockRowA, args->blockColB, args->blockSize);
+
+    for (int blockK = 0; blockK < blocksPerDim; ++blockK) {
+        accumulateTile(tileOf(*args->matrixA, args->blockRowA, blockK, args->blockSize),
+                       tileOf(*args->matrixB, blockK, args->blockColB, args->blockSize),
+                       tileC);
+    }
+}
+
+template <typename T, typename Acc>
+void multiplyPackedTileWorker(const BlockArgs<T, Acc>* args) {
+    TRACE_SCOPE("task", "packed tile", args->blockRowA, args->blockColB);
+    int size = args->matrixA->rows();
+    int blocksPerDim = (size + args->blockSize - 1) / args->blockSize;
+    MatrixView<Acc> tileC = tileOf(*args->resultMatrix, args->blockRowA, args->blockColB, args->blockSize);
+
+    for (int blockK = 0; blockK < blocksPerDim; ++blockK) {
+        multiplyTilePacked(*args->kernel,
+                           tileOf(*args->matrixA, args->blockRowA, blockK, args->blockSize),
+                           tileOf(*args->matrixB, blockK, args->blockColB, args->blockSize),
+                           tileC);
+    }
+}
+
+template <typename Executor, typename T, typename Acc>
+void multiplyBlockPartialWorker(const BlockArgs<T, Acc>* args) {
+    TRACE_SCOPE("task", "reduce block", args->blockRowA, args->blockColB, args->blockColA);
+    Matrix<Acc>& partial = (*args->partialResults)[Executor::workerIndex()];
+    accumulateTile(tileOf(*args->matrixA, args->blockRowA, args->blockColA, args->blockSize),
+                   tileOf(*args->matrixB, args->blockRowB, args->blockColB, args->blockSize),
+                   tileOf(partial, args->blockRowA, args->blockColB, args->blockSize));
+}
+
+template <typename Executor, typename Acc>
+void reducePartials(Executor& pool,
+                    const std::vector<Matrix<Acc>>& partialResults,
+                    Matrix<Acc>& resultMatrix) {
+    int size = resultMatrix.rows();
+    int rowsPerTask = std::max(1, size / static_cast<int>(pool.size()));
+    for (int startRow = 0; startRow < size; startRow += rowsPerTask) {
+        int endRow = std::min(startRow + rowsPerTask, size);
+        pool.submit([&partialResults, &resultMatrix, startRow, endRow] {
+            TRACE_SCOPE("task", "reduce rows", startRow, endRow);
+            for (const Matrix<Acc>& partial : partialResults) {
+                for (int i = startRow; i < endRow; ++i) {
+                    const Acc* source = partial.row(i);
+                    Acc* target = resultMatrix.row(i);
+                    for (size_t j = 0; j < partial.cols(); ++j) {
+                        target[j] += source[j];
+                    }
+                }
+            }
+        });
+    }
+    pool.wait();
+}
+
+} // namespace
+
+template <typename Executor, typename T, typename Acc>
+long long multiplyBlocked(ScheduleMode mode, const GemmKernel<T, Acc>* kernel, Executor& pool, int blockSize,
+                          const Matrix<T>& matrixA,
+                          const Matrix<T>& matrixB,
+                          Matrix<Acc>& resultMatrix,
+                          size_t& taskCount) {
+    int size = matrixA.rows();
+    int blocksPerDim = (size + blockSize - 1) / blockSize;
+
+    resultMatrix.fill(Acc());
+    std::vector<Matrix<Acc>> partialResults;
+    if (mode == ScheduleMode::Reduce) {
+        partialResults.assign(pool.size(), Matrix<Acc>(size, size));
+    }
+
+    std::vector<BlockArgs<T, Acc>> tasks;
+    bool ownsTile = mode == ScheduleMode::OwnerTile || mode == ScheduleMode::Packed;
+    int blocksK = ownsTile ? 1 : blocksPerDim;
+    tasks.reserve(static_cast<size_t>(blocksPerDim) * blocksPerDim * blocksK);
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    for (int blockI = 0; blockI < blocksPerDim; ++blockI) {
+        for (int blockJ = 0; blockJ < blocksPerDim; ++blockJ) {
+            for (int blockK = 0; blockK < blocksK; ++blockK) {
+                BlockArgs<T, Acc> args;
+                args.matrixA = &matrixA;
+                args.matrixB = &matrixB;
+                args.resultMatrix = &resultMatrix;
+                args.partialResults = &partialResults;
+                args.kernel = kernel;
+                args.blockRowA = blockI;
+                args.blockColA = blockK;
+                args.blockRowB = blockK;
+                args.blockColB = blockJ;
+                args.blockSize = blockSize;
+                tasks.push_back(args);
+            }
+        }
+    }
+
+    for (const BlockArgs<T, Acc>& args : tasks) {
+        const BlockArgs<T, Acc>* task = &args;
+        switch (mode) {
+        case ScheduleMode::Mutex:
+            pool.submit([task] { multiplyBlockWorker(task); });
+            break;
+        case ScheduleMode::OwnerTile:
+            pool.submit([task] { multiplyTileWorker(task); });
+            break;
+        case ScheduleMode::Reduce:
+            pool.submit([task] { multiplyBlockPartialWorker<Executor>(task); });
+            break;
+        case ScheduleMode::Packed:
+            pool.submit([task] { multiplyPackedTileWorker(task); });
+            break;
+        }
+    }
+    pool.wait();
+
+    if (mode == ScheduleMode::Reduce) {
+        reducePartials(pool, partialResults, resultMatrix);
+    }
+
+    auto endTime = std::chrono::steady_clock::now();
+    taskCount = tasks.size();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+}
+
+namespace {
+
+template <typename T, typename Acc>
+struct StealContext {
+    const Matrix<T>* matrixA;
+    const Matrix<T>* matrixB;
+    Matrix<Acc>* resultMatrix;
+    const GemmKernel<T, Acc>* kernel;
+    WorkStealingScheduler* scheduler;
+    int blockSize;
+    std::atomic<uint64_t> splits{ 0 };
+};
+
+// Computes rows [startRow, endRow) x cols [startCol, endCol) of C over the
+// whole K range. While some worker is idle the tile is halved along its
+// longer side and one half is handed back to the scheduler, so oversized
+// or late tiles do not leave the rest of the pool waiting.
+template <typename T, typename Acc>
+void multiplyStealTile(StealContext<T, Acc>* context, int startRow, int endRow, int startCol, int endCol) {
+    const int minSplit = 16;
+    while (context->scheduler->hasIdleWorkers()) {
+        int rows = endRow - startRow;
+        int cols = endCol - startCol;
+        if (std::max(rows, cols) < 2 * minSplit) {
+            break;
+        }
+        if (rows >= cols) {
+            int middle = startRow + rows / 2;
+            context->scheduler->submit([context, middle, endRow, startCol, endCol] {
+                multiplyStealTile(context, middle, endRow, startCol, endCol);
+            });
+            endRow = middle;
+        } else {
+            int middle = startCol + cols / 2;
+            context->scheduler->submit([context, startRow, endRow, middle, endCol] {
+                multiplyStealTile(context, startRow, endRow, middle, endCol);
+            });
+            endCol = middle;
+        }
+        context->splits.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    const int size = context->matrixA->rows();
+    const int rows = endRow - startRow;
+    const int cols = endCol - startCol;
+    TRACE_SCOPE("task", "steal tile", startRow, startCol, rows * cols);
+    MatrixView<Acc> tileC = context->resultMatrix->tile(startRow, startCol, rows, cols);
+    for (int startK = 0; startK < size; startK += context->blockSize) {
+        multiplyTilePacked(*context->kernel,
+                           context->matrixA->tile(startRow, startK, rows, context->blockSize),
+                           context->matrixB->tile(startK, startCol, context->blockSize, cols),
+                           tileC);
+    }
+}
+
+} // namespace
+
+template <typename T, typename Acc>
+long long multiplyStealing(const GemmKernel<T, Acc>& kernel, WorkStealingScheduler& scheduler, int blockSize,
+                           const Matrix<T>& matrixA,
+                           const Matrix<T>& matrixB,
+                           Matrix<Acc>& resultMatrix,
+                           size_t& taskCount, uint64_t& splitCount) {
+    int size = matrixA.rows();
+    int blocksPerDim = (size + blockSize - 1) / blockSize;
+
+    resultMatrix.fill(Acc());
+    scheduler.resetStats();
+    StealContext<T, Acc> context;
+    context.matrixA = &matrixA;
+    context.matrixB = &matrixB;
+    context.resultMatrix = &resultMatrix;
+    context.kernel = &kernel;
+    context.scheduler = &scheduler;
+    context.blockSize = blockSize;
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    for (int blockI = 0; blockI < blocksPerDim; ++blockI) {
+        for (int blockJ = 0; blockJ < blocksPerDim; ++blockJ) {
+            int startRow = blockI * blockSize;
+            int startCol = blockJ * blockSize;
+            int endRow = std::min(startRow + blockSize, size);
+            int endCol = std::min(startCol + blockSize, size);
+            StealContext<T, Acc>* shared = &context;
+            scheduler.submit([shared, startRow, endRow, startCol, endCol] {
+                multiplyStealTile(shared, startRow, endRow, startCol, endCol);
+            });
+        }
+    }
+    scheduler.wait();
+
+    auto endTime = std::chrono::steady_clock::now();
+    taskCount = static_cast<size_t>(blocksPerDim) * blocksPerDim;
+    splitCount = context.splits.load();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+}
+
+#define INSTANTIATE_BLOCKED(Executor, T, Acc)                                                                    \
+    template long long multiplyBlocked<Executor, T, Acc>(ScheduleMode, const GemmKernel<T, Acc>*, Executor&, int, \
+                                                         const Matrix<T>&, const Matrix<T>&, Matrix<Acc>&, size_t&);
+
+#define INSTANTIATE_BLOCKED_ALL(T, Acc)                                                                          \
+    template void naiveProduct<T, Acc>(MatrixView<const T>, MatrixView<const T>, MatrixView<Acc>);              \
+    template long long multiplyNaive<T, Acc>(const Matrix<T>&, const Matrix<T>&, Matrix<Acc>&);                 \
+    template long long multiplyStealing<T, Acc>(const GemmKernel<T, Acc>&, WorkStealingScheduler&, int,          \
+                                                const Matrix<T>&, const Matrix<T>&, Matrix<Acc>&, size_t&,       \
+                                                uint64_t&);                                                      \
+    INSTANTIATE_BLOCKED(ThreadPool, T, Acc)                                                                      \
+    INSTANTIATE_BLOCKED(PthreadSpawner, T, Acc)                                                                  \
+    INSTANTIATE_BLOCKED(StdThreadSpawner, T, Acc)
+
+INSTANTIATE_BLOCKED_ALL(int, int)
+INSTANTIATE_BLOCKED_ALL(int, int64_t)
+INSTANTIATE_BLOCKED_ALL(float, float)
+INSTANTIATE_BLOCKED_ALL(double, double)
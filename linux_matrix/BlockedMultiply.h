@@ -0,0 +1,56 @@
+#ifndef BLOCKED_MULTIPLY
+#define BLOCKED_MULTIPLY
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "GemmKernel.h"
+#include "Matrix.h"
+#include "ThreadPool.h"
+#include "ThreadSpawner.h"
+#include "WorkStealingScheduler.h"
+
+// The square products of the benchmark that split C into blockSize x
+// blockSize tiles, and the naive reference they are checked against. T is
+// the element type of A and B, Acc the type of C (see ElementType.h); all
+// four pairs of GemmKernel are instantiated. Each function overwrites C and
+// returns the nanoseconds it spent multiplying, without the allocation of
+// its scratch matrices.
+
+enum class ScheduleMode {
+    Mutex,      // one task per (blockI, blockJ, blockK), += under a mutex
+    OwnerTile,  // one task per C tile, loops over blockK itself, no lock
+    Reduce,     // K-split into per-worker partial results, summed at the end
+    Packed      // like OwnerTile, but packs operands for a SIMD micro-kernel
+};
+
+const char* scheduleModeName(ScheduleMode mode);
+
+// Sets mode and returns true when name is a scheduleModeName.
+bool parseScheduleMode(const std::string& name, ScheduleMode& mode);
+
+// C = A * B for any m x k by k x n views, one dot product per element.
+template <typename T, typename Acc>
+void naiveProduct(MatrixView<const T> matrixA, MatrixView<const T> matrixB, MatrixView<Acc> resultMatrix);
+
+template <typename T, typename Acc>
+long long multiplyNaive(const Matrix<T>& matrixA, const Matrix<T>& matrixB, Matrix<Acc>& resultMatrix);
+
+// One task per tile (per tile and K block for Mutex and Reduce), run by
+// executor: a ThreadPool, PthreadSpawner or StdThreadSpawner. kernel is
+// used by Packed only and may be null otherwise. taskCount receives the
+// number of tile tasks.
+template <typename Executor, typename T, typename Acc>
+long long multiplyBlocked(ScheduleMode mode, const GemmKernel<T, Acc>* kernel, Executor& executor, int blockSize,
+                          const Matrix<T>& matrixA, const Matrix<T>& matrixB, Matrix<Acc>& resultMatrix,
+                          size_t& taskCount);
+
+// One packed task per tile on scheduler; a task splits its tile in half
+// and hands one half back while some worker is idle. taskCount receives
+// the initial tiles, splitCount the splits.
+template <typename T, typename Acc>
+long long multiplyStealing(const GemmKernel<T, Acc>& kernel, WorkStealingScheduler& scheduler, int blockSize,
+                           const Matrix<T>& matrixA, const Matrix<T>& matrixB, Matrix<Acc>& resultMatrix,
+                           size_t& taskCount, uint64_t& splitCount);
+
+#endif // BLOCKED_MULTIPLY
@@ -0,0 +1,83 @@
+#ifndef ELEMENT_TYPE_H
+#define ELEMENT_TYPE_H
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+// Element type of A and B and accumulator type of C for one benchmark run.
+// Int64, the default, keeps int operands but accumulates and stores C in
+// int64_t, so it cannot overflow for any size the benchmark can hold in
+// memory. Int32 accumulates in int and wraps like the original code, past
+// size * 100 * 100 > INT_MAX with the benchmark's values (N of about 215k);
+// the benchmark warns before such runs.
+enum class ElementType {
+    Int32,
+    Int64,
+    Float,
+    Double
+};
+
+template <ElementType Type>
+struct ElementTraits;
+
+template <>
+struct ElementTraits<ElementType::Int32> {
+    using Element = int;
+    using Accumulator = int;
+};
+
+template <>
+struct ElementTraits<ElementType::Int64> {
+    using Element = int;
+    using Accumulator = int64_t;
+};
+
+template <>
+struct ElementTraits<ElementType::Float> {
+    using Element = float;
+    using Accumulator = float;
+};
+
+template <>
+struct ElementTraits<ElementType::Double> {
+    using Element = double;
+    using Accumulator = double;
+};
+
+inline const char* elementTypeName(ElementType type) {
+    switch (type) {
+    case ElementType::Int32: return "int32";
+    case ElementType::Int64: return "int64";
+    case ElementType::Float: return "float";
+    case ElementType::Double: return "double";
+    }
+    return "?";
+}
+
+// Throws std::invalid_argument for anything but the names above.
+inline ElementType parseElementType(const std::string& name) {
+    const ElementType types[] = { ElementType::Int32, ElementType::Int64, ElementType::Float, ElementType::Double };
+    for (ElementType type : types) {
+        if (name == elementTypeName(type)) {
+            return type;
+        }
+    }
+    throw std::invalid_argument("--dtype: expected int32, int64, float or double, got '" + name + "'");
+}
+
+// Calls function(std::integral_constant<ElementType, type>()), turning a
+// run-time type into a template argument:
+//   dispatchElementType(type, [&](auto tag) { run<decltype(tag)::value>(); });
+template <typename Function>
+void dispatchElementType(ElementType type, Function&& function) {
+    switch (type) {
+    case ElementType::Int32: function(std::integral_constant<ElementType, ElementType::Int32>()); break;
+    case ElementType::Int64: function(std::integral_constant<ElementType, ElementType::Int64>()); break;
+    case ElementType::Float: function(std::integral_constant<ElementType, ElementType::Float>()); break;
+    case ElementType::Double: function(std::integral_constant<ElementType, ElementType::Double>()); break;
+    }
+}
+
+#endif // ELEMENT_TYPE_H
@@ -0,0 +1,144 @@
+#include "Gemm.h"
+
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include "GotoGemm.h"
+#include "Matrix.h"
+
+namespace {
+
+void checkShape(const char* function, int m, int n, int k, size_t lda, size_t ldb, size_t ldc) {
+    if (m < 0 || n < 0 || k < 0) {
+        throw std::invalid_argument(std::string(function) + ": negative dimension");
+    }
+    if (lda < static_cast<size_t>(k) || ldb < static_cast<size_t>(n) || ldc < static_cast<size_t>(n)) {
+        throw std::invalid_argument(std::string(function) + ": leading dimension shorter than a row");
+    }
+}
+
+// Rows [firstRow, endRow) of C = beta * C, without reading C when beta is 0.
+template <typename Acc>
+void scaleRows(MatrixView<Acc> c, size_t firstRow, size_t endRow, Acc beta) {
+    for (size_t i = firstRow; i < endRow; ++i) {
+        Acc* row = c.row(i);
+        if (beta == Acc(0)) {
+            std::fill(row, row + c.cols(), Acc());
+        } else if (beta != Acc(1)) {
+            for (size_t j = 0; j < c.cols(); ++j) {
+                row[j] *= beta;
+            }
+        }
+    }
+}
+
+// Rows [firstRow, endRow) of C += alpha * product.
+template <typename Acc>
+void addScaledRows(MatrixView<Acc> c, const Matrix<Acc>& product, size_t firstRow, size_t endRow, Acc alpha) {
+    for (size_t i = firstRow; i < endRow; ++i) {
+        Acc* row = c.row(i);
+        const Acc* source = product.row(i);
+        for (size_t j = 0; j < c.cols(); ++j) {
+            row[j] += alpha * source[j];
+        }
+    }
+}
+
+// One product on the calling thread.
+template <typename T, typename Acc>
+void gemmSerial(const GemmKernel<T, Acc>& kernel, MatrixView<const T> a, MatrixView<const T> b,
+                MatrixView<Acc> c, Acc alpha, Acc beta) {
+    scaleRows(c, 0, c.rows(), beta);
+    if (alpha == Acc(0) || a.cols() == 0) {
+        return;
+    }
+    if (alpha == Acc(1)) {
+        multiplyTilePacked(kernel, a, b, c);
+        return;
+    }
+    // Reused by every product a thread computes, like the packing buffers.
+    thread_local Matrix<Acc> product;
+    if (product.rows() < c.rows() || product.cols() < c.cols()) {
+        product = Matrix<Acc>(std::max(product.rows(), c.rows()), std::max(product.cols(), c.cols()));
+    }
+    MatrixView<Acc> productView = product.tile(0, 0, c.rows(), c.cols());
+    scaleRows(productView, 0, c.rows(), Acc(0));
+    multiplyTilePacked(kernel, a, b, productView);
+    addScaledRows(c, product, 0, c.rows(), alpha);
+}
+
+} // namespace
+
+template <typename T, typename Acc>
+void gemm(const GemmKernel<T, Acc>& kernel, ThreadPool& pool, int m, int n, int k,
+          const T* a, size_t lda, const T* b, size_t ldb, Acc* c, size_t ldc, Acc alpha, Acc beta) {
+    checkShape("gemm", m, n, k, lda, ldb, ldc);
+    if (m == 0 || n == 0) {
+        return;
+    }
+    MatrixView<const T> viewA(a, m, k, lda);
+    MatrixView<const T> viewB(b, k, n, ldb);
+    MatrixView<Acc> viewC(c, m, n, ldc);
+    if (static_cast<double>(m) * n * k < gemmParallelOps) {
+        gemmSerial(kernel, viewA, viewB, viewC, alpha, beta);
+        return;
+    }
+
+    // Row bands per worker for the O(m * n) passes over C.
+    const size_t workers = pool.size();
+    auto forEachBand = [&](const std::function<void(size_t, size_t)>& function) {
+        pool.runOnEachWorker([&](int worker) {
+            function(m * static_cast<size_t>(worker) / workers, m * static_cast<size_t>(worker + 1) / workers);
+        });
+    };
+    forEachBand([&](size_t firstRow, size_t endRow) { scaleRows(viewC, firstRow, endRow, beta); });
+    if (alpha == Acc(0) || k == 0) {
+        return;
+    }
+    const CacheBlocking blocking = deriveCacheBlocking(kernel);
+    if (alpha == Acc(1)) {
+        multiplyGoto(kernel, blocking, pool, viewA, viewB, viewC);
+        return;
+    }
+    Matrix<Acc> product(m, n);
+    multiplyGoto(kernel, blocking, pool, viewA, viewB, product.view());
+    forEachBand([&](size_t firstRow, size_t endRow) { addScaledRows(viewC, product, firstRow, endRow, alpha); });
+}
+
+template <typename T, typename Acc>
+void gemmStridedBatched(const GemmKernel<T, Acc>& kernel, ThreadPool& pool, int m, int n, int k,
+                        const T* a, size_t lda, size_t strideA, const T* b, size_t ldb, size_t strideB,
+                        Acc* c, size_t ldc, size_t strideC, size_t batchCount, Acc alpha, Acc beta) {
+    checkShape("gemmStridedBatched", m, n, k, lda, ldb, ldc);
+    if (m == 0 || n == 0 || batchCount == 0) {
+        return;
+    }
+    // A few runs per worker even out products that finish at different
+    // speeds without paying a task per product.
+    const size_t runs = std::min(batchCount, static_cast<size_t>(pool.size()) * 4);
+    for (size_t run = 0; run < runs; ++run) {
+        const size_t first = batchCount * run / runs;
+        const size_t end = batchCount * (run + 1) / runs;
+        pool.submit([=, &kernel] {
+            for (size_t i = first; i < end; ++i) {
+                gemmSerial(kernel, MatrixView<const T>(a + i * strideA, m, k, lda),
+                           MatrixView<const T>(b + i * strideB, k, n, ldb),
+                           MatrixView<Acc>(c + i * strideC, m, n, ldc), alpha, beta);
+            }
+        });
+    }
+    pool.wait();
+}
+
+#define INSTANTIATE_GEMM(T, Acc)                                                                                 \
+    template void gemm<T, Acc>(const GemmKernel<T, Acc>&, ThreadPool&, int, int, int, const T*, size_t,         \
+                               const T*, size_t, Acc*, size_t, Acc, Acc);                                       \
+    template void gemmStridedBatched<T, Acc>(const GemmKernel<T, Acc>&, ThreadPool&, int, int, int, const T*,   \
+                                             size_t, size_t, const T*, size_t, size_t, Acc*, size_t, size_t,    \
+                                             size_t, Acc, Acc);
+
+INSTANTIATE_GEMM(int, int)
+INSTANTIATE_GEMM(int, int64_t)
+INSTANTIATE_GEMM(float, float)
+INSTANTIATE_GEMM(double, double)
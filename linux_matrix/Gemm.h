@@ -0,0 +1,37 @@
+#ifndef GEMM_H
+#define GEMM_H
+
+#include <cstddef>
+#include "GemmKernel.h"
+#include "ThreadPool.h"
+
+// BLAS-style products over row-major arrays. ld* is the leading dimension
+// of an operand, the elements between the starts of consecutive rows
+// (at least its column count). Instantiated for the element/accumulator
+// pairs of GemmKernel.
+
+// C (m x n) = alpha * A (m x k) * B (k x n) + beta * C. As in BLAS, C is
+// not read when beta is zero and A and B are not read when alpha or k is
+// zero. Products of at least gemmParallelOps multiply-adds run the goto
+// loop nest on the pool; smaller ones run packed on the calling thread,
+// where handing out tasks would cost more than the product. Throws
+// std::invalid_argument for negative sizes or short leading dimensions.
+template <typename T, typename Acc>
+void gemm(const GemmKernel<T, Acc>& kernel, ThreadPool& pool, int m, int n, int k,
+          const T* a, size_t lda, const T* b, size_t ldb, Acc* c, size_t ldc,
+          Acc alpha = Acc(1), Acc beta = Acc(0));
+
+const double gemmParallelOps = 128.0 * 128.0 * 128.0;
+
+// batchCount independent products C_i = alpha * A_i * B_i + beta * C_i of
+// the same shape, where X_i starts stride* elements after X_(i-1). Whole
+// products are spread across the pool in contiguous runs, each computed
+// on one worker as gemm's serial path does, instead of tiling every small
+// product across all workers.
+template <typename T, typename Acc>
+void gemmStridedBatched(const GemmKernel<T, Acc>& kernel, ThreadPool& pool, int m, int n, int k,
+                        const T* a, size_t lda, size_t strideA, const T* b, size_t ldb, size_t strideB,
+                        Acc* c, size_t ldc, size_t strideC, size_t batchCount,
+                        Acc alpha = Acc(1), Acc beta = Acc(0));
+
+#endif // GEMM_H
@@ -0,0 +1,547 @@
+#include "GemmKernel.h"
+
+#include <immintrin.h>
+#include <stdexcept>
+
+namespace {
+
+template <typename T, typename Acc>
+void computeScalar(int kc, const T* packedA, const T* packedB, Acc* c, size_t ldc) {
+    constexpr int MR = 4;
+    constexpr int NR = 16;
+    Acc acc[MR][NR] = {};
+    for (int k = 0; k < kc; ++k) {
+        const T* a = packedA + k * MR;
+        const T* b = packedB + k * NR;
+        for (int r = 0; r < MR; ++r) {
+            for (int j = 0; j < NR; ++j) {
+                acc[r][j] += static_cast<Acc>(a[r]) * static_cast<Acc>(b[j]);
+            }
+        }
+    }
+    for (int r = 0; r < MR; ++r) {
+        for (int j = 0; j < NR; ++j) {
+            c[r * ldc + j] += acc[r][j];
+        }
+    }
+}
+
+__attribute__((target("sse4.1")))
+void computeSse41(int kc, const int* packedA, const int* packedB, int* c, size_t ldc) {
+    constexpr int MR = 4;
+    constexpr int NR = 8;
+    __m128i acc[MR][2];
+#pragma GCC unroll 4
+    for (int r = 0; r < MR; ++r) {
+        acc[r][0] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(c + r * ldc));
+        acc[r][1] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(c + r * ldc + 4));
+    }
+    for (int k = 0; k < kc; ++k) {
+        __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(packedB + k * NR));
+        __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(packedB + k * NR + 4));
+#pragma GCC unroll 4
+        for (int r = 0; r < MR; ++r) {
+            __m128i a = _mm_set1_epi32(packedA[k * MR + r]);
+            acc[r][0] = _mm_add_epi32(acc[r][0], _mm_mullo_epi32(a, b0));
+            acc[r][1] = _mm_add_epi32(acc[r][1], _mm_mullo_epi32(a, b1));
+        }
+    }
+#pragma GCC unroll 4
+    for (int r = 0; r < MR; ++r) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(c + r * ldc), acc[r][0]);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(c + r * ldc + 4), acc[r][1]);
+    }
+}
+
+__attribute__((target("avx2")))
+void computeAvx2(int kc, const int* packedA, const int* packedB, int* c, size_t ldc) {
+    constexpr int MR = 4;
+    constexpr int NR = 16;
+    __m256i acc[MR][2];
+#pragma GCC unroll 4
+    for (int r = 0; r < MR; ++r) {
+        acc[r][0] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(c + r * ldc));
+        acc[r][1] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(c + r * ldc + 8));
+    }
+    for (int k = 0; k < kc; ++k) {
+        __m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(packedB + k * NR));
+        __m256i b1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(packedB + k * NR + 8));
+#pragma GCC unroll 4
+        for (int r = 0; r < MR; ++r) {
+            __m256i a = _mm256_set1_epi32(packedA[k * MR + r]);
+            acc[r][0] = _mm256_add_epi32(acc[r][0], _mm256_mullo_epi32(a, b0));
+            acc[r][1] = _mm256_add_epi32(acc[r][1], _mm256_mullo_epi32(a, b1));
+        }
+    }
+#pragma GCC unroll 4
+    for (int r = 0; r < MR; ++r) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(c + r * ldc), acc[r][0]);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(c + r * ldc + 8), acc[r][1]);
+    }
+}
+
+__attribute__((target("avx512f")))
+void computeAvx512(int kc, const int* packedA, const int* packedB, int* c, size_t ldc) {
+    constexpr int MR = 8;
+    constexpr int NR = 16;
+    __m512i acc[MR];
+#pragma GCC unroll 8
+    for (int r = 0; r < MR; ++r) {
+        acc[r] = _mm512_loadu_si512(c + r * ldc);
+    }
+    for (int k = 0; k < kc; ++k) {
+        __m512i b = _mm512_loadu_si512(packedB + k * NR);
+#pragma GCC unroll 8
+        for (int r = 0; r < MR; ++r) {
+            acc[r] = _mm512_add_epi32(acc[r], _mm512_mullo_epi32(_mm512_set1_epi32(packedA[k * MR + r]), b));
+        }
+    }
+#pragma GCC unroll 8
+    for (int r = 0; r < MR; ++r) {
+        _mm512_storeu_si512(c + r * ldc, acc[r]);
+    }
+}
+
+// int operands, int64_t accumulators: _mm*_mul_epi32 multiplies the low
+// signed 32 bits of each 64-bit lane into a full 64-bit product, so B is
+// sign-extended into 64-bit lanes and A broadcast as 32-bit values.
+
+__attribute__((target("sse4.1")))
+void computeSse41Int64(int kc, const int* packedA, const int* packedB, int64_t* c, size_t ldc) {
+    constexpr int MR = 4;
+    constexpr int NR = 4;
+    __m128i acc[MR][2];
+#pragma GCC unroll 4
+    for (int r = 0; r < MR; ++r) {
+        acc[r][0] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(c + r * ldc));
+        acc[r][1] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(c + r * ldc + 2));
+    }
+    for (int k = 0; k < kc; ++k) {
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(packedB + k * NR));
+        __m128i b0 = _mm_cvtepi32_epi64(b);
+        __m128i b1 = _mm_cvtepi32_epi64(_mm_srli_si128(b, 8));
+#pragma GCC unroll 4
+        for (int r = 0; r < MR; ++r) {
+            __m128i a = _mm_set1_epi32(packedA[k * MR + r]);
+            acc[r][0] = _mm_add_epi64(acc[r][0], _mm_mul_epi32(a, b0));
+            acc[r][1] = _mm_add_epi64(acc[r][1], _mm_mul_epi32(a, b1));
+        }
+    }
+#pragma GCC unroll 4
+    for (int r = 0; r < MR; ++r) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(c + r * ldc), acc[r][0]);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(c + r * ldc + 2), acc[r][1]);
+    }
+}
+
+__attribute__((target("avx2")))
+void computeAvx2Int64(int kc, const int* packedA, const int* packedB, int64_t* c, size_t ldc) {
+    constexpr int MR = 4;
+    constexpr int NR = 8;
+    __m256i acc[MR][2];
+#pragma GCC unroll 4
+    for (int r = 0; r < MR; ++r) {
+        acc[r][0] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(c + r * ldc));
+        acc[r][1] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(c + r * ldc + 4));
+    }
+    for (int k = 0; k < kc; ++k) {
+        __m256i b0 = _mm256_cvtepi32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(packedB + k * NR)));
+        __m256i b1 = _mm256_cvtepi32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(packedB + k * NR + 4)));
+#pragma GCC unroll 4
+        for (int r = 0; r < MR; ++r) {
+            __m256i a = _mm256_set1_epi32(packedA[k * MR + r]);
+            acc[r][0] = _mm256_add_epi64(acc[r][0], _mm256_mul_epi32(a, b0));
+            acc[r][1] = _mm256_add_epi64(acc[r][1], _mm256_mul_epi32(a, b1));
+        }
+    }
+#pragma GCC unroll 4
+    for (int r = 0; r < MR; ++r) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(c + r * ldc), acc[r][0]);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(c + r * ldc + 4), acc[r][1]);
+    }
+}
+
+// GCC 12's avx512fintrin.h self-initializes the undefined source operand
+// of pmovsxdq/pmuldq, which trips -Wmaybe-uninitialized once inlined.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+__attribute__((target("avx512f")))
+void computeAvx512Int64(int kc, const int* packedA, const int* packedB, int64_t* c, size_t ldc) {
+    constexpr int MR = 8;
+    constexpr int NR = 16;
+    __m512i acc[MR][2];
+#pragma GCC unroll 8
+    for (int r = 0; r < MR; ++r) {
+        acc[r][0] = _mm512_loadu_si512(c + r * ldc);
+        acc[r][1] = _mm512_loadu_si512(c + r * ldc + 8);
+    }
+    for (int k = 0; k < kc; ++k) {
+        __m512i b0 = _mm512_cvtepi32_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(packedB + k * NR)));
+        __m512i b1 = _mm512_cvtepi32_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(packedB + k * NR + 8)));
+#pragma GCC unroll 8
+        for (int r = 0; r < MR; ++r) {
+            __m512i a = _mm512_set1_epi32(packedA[k * MR + r]);
+            acc[r][0] = _mm512_add_epi64(acc[r][0], _mm512_mul_epi32(a, b0));
+            acc[r][1] = _mm512_add_epi64(acc[r][1], _mm512_mul_epi32(a, b1));
+        }
+    }
+#pragma GCC unroll 8
+    for (int r = 0; r < MR; ++r) {
+        _mm512_storeu_si512(c + r * ldc, acc[r][0]);
+        _mm512_storeu_si512(c + r * ldc + 8, acc[r][1]);
+    }
+}
+#pragma GCC diagnostic pop
+
+// Floating point kernels. The avx2 and avx512 ones use fused multiply-add,
+// so their sums differ from the naive loop in the last bits.
+
+__attribute__((target("sse4.1")))
+void computeSse41Float(int kc, const float* packedA, const float* packedB, float* c, size_t ldc) {
+    constexpr int MR = 4;
+    constexpr int NR = 8;
+    __m128 acc[MR][2];
+#pragma GCC unroll 4
+    for (int r = 0; r < MR; ++r) {
+        acc[r][0] = _mm_loadu_ps(c + r * ldc);
+        acc[r][1] = _mm_loadu_ps(c + r * ldc + 4);
+    }
+    for (int k = 0; k < kc; ++k) {
+        __m128 b0 = _mm_loadu_ps(packedB + k * NR);
+        __m128 b1 = _mm_loadu_ps(packedB + k * NR + 4);
+#pragma GCC unroll 4
+        for (int r = 0; r < MR; ++r) {
+            __m128 a = _mm_set1_ps(packedA[k * MR + r]);
+            acc[r][0] = _mm_add_ps(acc[r][0], _mm_mul_ps(a, b0));
+            acc[r][1] = _mm_add_ps(acc[r][1], _mm_mul_ps(a, b1));
+        }
+    }
+#pragma GCC unroll 4
+    for (int r = 0; r < MR; ++r) {
+        _mm_storeu_ps(c + r * ldc, acc[r][0]);
+        _mm_storeu_ps(c + r * ldc + 4, acc[r][1]);
+    }
+}
+
+__attribute__((target("avx2,fma")))
+void computeAvx2Float(int kc, const float* packedA, const float* packedB, float* c, size_t ldc) {
+    constexpr int MR = 4;
+    constexpr int NR = 16;
+    __m256 acc[MR][2];
+#pragma GCC unroll 4
+    for (int r = 0; r < MR; ++r) {
+        acc[r][0] = _mm256_loadu_ps(c + r * ldc);
+        acc[r][1] = _mm256_loadu_ps(c + r * ldc + 8);
+    }
+    for (int k = 0; k < kc; ++k) {
+        __m256 b0 = _mm256_loadu_ps(packedB + k * NR);
+        __m256 b1 = _mm256_loadu_ps(packedB + k * NR + 8);
+#pragma GCC unroll 4
+        for (int r = 0; r < MR; ++r) {
+            __m256 a = _mm256_set1_ps(packedA[k * MR + r]);
+            acc[r][0] = _mm256_fmadd_ps(a, b0, acc[r][0]);
+            acc[r][1] = _mm256_fmadd_ps(a, b1, acc[r][1]);
+        }
+    }
+#pragma GCC unroll 4
+    for (int r = 0; r < MR; ++r) {
+        _mm256_storeu_ps(c + r * ldc, acc[r][0]);
+        _mm256_storeu_ps(c + r * ldc + 8, acc[r][1]);
+    }
+}
+
+__attribute__((target("avx512f")))
+void computeAvx512Float(int kc, const float* packedA, const float* packedB, float* c, size_t ldc) {
+    constexpr int MR = 8;
+    constexpr int NR = 16;
+    __m512 acc[MR];
+#pragma GCC unroll 8
+    for (int r = 0; r < MR; ++r) {
+        acc[r] = _mm512_loadu_ps(c + r * ldc);
+    }
+    for (int k = 0; k < kc; ++k) {
+        __m512 b = _mm512_loadu_ps(packedB + k * NR);
+#pragma GCC unroll 8
+        for (int r = 0; r < MR; ++r) {
+            acc[r] = _mm512_fmadd_ps(_mm512_set1_ps(packedA[k * MR + r]), b, acc[r]);
+        }
+    }
+#pragma GCC unroll 8
+    for (int r = 0; r < MR; ++r) {
+        _mm512_storeu_ps(c + r * ldc, acc[r]);
+    }
+}
+
+__attribute__((target("sse4.1")))
+void computeSse41Double(int kc, const double* packedA, const double* packedB, double* c, size_t ldc) {
+    constexpr int MR = 4;
+    constexpr int NR = 4;
+    __m128d acc[MR][2];
+#pragma GCC unroll 4
+    for (int r = 0; r < MR; ++r) {
+        acc[r][0] = _mm_loadu_pd(c + r * ldc);
+        acc[r][1] = _mm_loadu_pd(c + r * ldc + 2);
+    }
+    for (int k = 0; k < kc; ++k) {
+        __m128d b0 = _mm_loadu_pd(packedB + k * NR);
+        __m128d b1 = _mm_loadu_pd(packedB + k * NR + 2);
+#pragma GCC unroll 4
+        for (int r = 0; r < MR; ++r) {
+            __m128d a = _mm_set1_pd(packedA[k * MR + r]);
+            acc[r][0] = _mm_add_pd(acc[r][0], _mm_mul_pd(a, b0));
+            acc[r][1] = _mm_add_pd(acc[r][1], _mm_mul_pd(a, b1));
+        }
+    }
+#pragma GCC unroll 4
+    for (int r = 0; r < MR; ++r) {
+        _mm_storeu_pd(c + r * ldc, acc[r][0]);
+        _mm_storeu_pd(c + r * ldc + 2, acc[r][1]);
+    }
+}
+
+__attribute__((target("avx2,fma")))
+void computeAvx2Double(int kc, const double* packedA, const double* packedB, double* c, size_t ldc) {
+    constexpr int MR = 4;
+    constexpr int NR = 8;
+    __m256d acc[MR][2];
+#pragma GCC unroll 4
+    for (int r = 0; r < MR; ++r) {
+        acc[r][0] = _mm256_loadu_pd(c + r * ldc);
+        acc[r][1] = _mm256_loadu_pd(c + r * ldc + 4);
+    }
+    for (int k = 0; k < kc; ++k) {
+        __m256d b0 = _mm256_loadu_pd(packedB + k * NR);
+        __m256d b1 = _mm256_loadu_pd(packedB + k * NR + 4);
+#pragma GCC unroll 4
+        for (int r = 0; r < MR; ++r) {
+            __m256d a = _mm256_set1_pd(packedA[k * MR + r]);
+            acc[r][0] = _mm256_fmadd_pd(a, b0, acc[r][0]);
+            acc[r][1] = _mm256_fmadd_pd(a, b1, acc[r][1]);
+        }
+    }
+#pragma GCC unroll 4
+    for (int r = 0; r < MR; ++r) {
+        _mm256_storeu_pd(c + r * ldc, acc[r][0]);
+        _mm256_storeu_pd(c + r * ldc + 4, acc[r][1]);
+    }
+}
+
+__attribute__((target("avx512f")))
+void computeAvx512Double(int kc, const double* packedA, const double* packedB, double* c, size_t ldc) {
+    constexpr int MR = 8;
+    constexpr int NR = 16;
+    __m512d acc[MR][2];
+#pragma GCC unroll 8
+    for (int r = 0; r < MR; ++r) {
+        acc[r][0] = _mm512_loadu_pd(c + r * ldc);
+        acc[r][1] = _mm512_loadu_pd(c + r * ldc + 8);
+    }
+    for (int k = 0; k < kc; ++k) {
+        __m512d b0 = _mm512_loadu_pd(packedB + k * NR);
+        __m512d b1 = _mm512_loadu_pd(packedB + k * NR + 8);
+#pragma GCC unroll 8
+        for (int r = 0; r < MR; ++r) {
+            __m512d a = _mm512_set1_pd(packedA[k * MR + r]);
+            acc[r][0] = _mm512_fmadd_pd(a, b0, acc[r][0]);
+            acc[r][1] = _mm512_fmadd_pd(a, b1, acc[r][1]);
+        }
+    }
+#pragma GCC unroll 8
+    for (int r = 0; r < MR; ++r) {
+        _mm512_storeu_pd(c + r * ldc, acc[r][0]);
+        _mm512_storeu_pd(c + r * ldc + 8, acc[r][1]);
+    }
+}
+
+template <typename T, typename Acc>
+struct KernelEntry {
+    GemmKernel<T, Acc> kernel;
+    bool (*supported)();
+};
+
+bool anyCpu() { return true; }
+bool hasSse41() { return __builtin_cpu_supports("sse4.1") != 0; }
+bool hasAvx2() { return __builtin_cpu_supports("avx2") != 0; }
+bool hasAvx2Fma() { return __builtin_cpu_supports("avx2") != 0 && __builtin_cpu_supports("fma") != 0; }
+bool hasAvx512() { return __builtin_cpu_supports("avx512f") != 0; }
+
+// Kernels per element/accumulator pair, narrowest first.
+template <typename T, typename Acc>
+struct KernelTable {
+    static const KernelEntry<T, Acc> entries[4];
+};
+
+template <>
+const KernelEntry<int, int> KernelTable<int, int>::entries[4] = {
+    { { "scalar", 4, 16, computeScalar<int, int> }, anyCpu },
+    { { "sse4.1", 4, 8, computeSse41 }, hasSse41 },
+    { { "avx2", 4, 16, computeAvx2 }, hasAvx2 },
+    { { "avx512", 8, 16, computeAvx512 }, hasAvx512 },
+};
+
+template <>
+const KernelEntry<int, int64_t> KernelTable<int, int64_t>::entries[4] = {
+    { { "scalar", 4, 16, computeScalar<int, int64_t> }, anyCpu },
+    { { "sse4.1", 4, 4, computeSse41Int64 }, hasSse41 },
+    { { "avx2", 4, 8, computeAvx2Int64 }, hasAvx2 },
+    { { "avx512", 8, 16, computeAvx512Int64 }, hasAvx512 },
+};
+
+template <>
+const KernelEntry<float, float> KernelTable<float, float>::entries[4] = {
+    { { "scalar", 4, 16, computeScalar<float, float> }, anyCpu },
+    { { "sse4.1", 4, 8, computeSse41Float }, hasSse41 },
+    { { "avx2", 4, 16, computeAvx2Float }, hasAvx2Fma },
+    { { "avx512", 8, 16, computeAvx512Float }, hasAvx512 },
+};
+
+template <>
+const KernelEntry<double, double> KernelTable<double, double>::entries[4] = {
+    { { "scalar", 4, 16, computeScalar<double, double> }, anyCpu },
+    { { "sse4.1", 4, 4, computeSse41Double }, hasSse41 },
+    { { "avx2", 4, 8, computeAvx2Double }, hasAvx2Fma },
+    { { "avx512", 8, 16, computeAvx512Double }, hasAvx512 },
+};
+
+} // namespace
+
+template <typename T, typename Acc>
+const GemmKernel<T, Acc>& selectGemmKernel(const std::string& isa) {
+    __builtin_cpu_init();
+    if (isa == "auto") {
+        return *supportedGemmKernels<T, Acc>().back();
+    }
+    for (const KernelEntry<T, Acc>& entry : KernelTable<T, Acc>::entries) {
+        if (isa == entry.kernel.name) {
+            if (!entry.supported()) {
+                throw std::runtime_error("GemmKernel: CPU does not support " + isa);
+            }
+            return entry.kernel;
+        }
+    }
+    throw std::invalid_argument("GemmKernel: unknown ISA '" + isa + "'");
+}
+
+template <typename T, typename Acc>
+std::vector<const GemmKernel<T, Acc>*> supportedGemmKernels() {
+    __builtin_cpu_init();
+    std::vector<const GemmKernel<T, Acc>*> result;
+    for (const KernelEntry<T, Acc>& entry : KernelTable<T, Acc>::entries) {
+        if (entry.supported()) {
+            result.push_back(&entry.kernel);
+        }
+    }
+    return result;
+}
+
+template <typename T>
+void packPanelA(MatrixView<const T> blockA, int mr, T* packed) {
+    const size_t rows = blockA.rows();
+    const size_t kc = blockA.cols();
+    for (size_t startRow = 0; startRow < rows; startRow += mr) {
+        for (size_t k = 0; k < kc; ++k) {
+            for (int r = 0; r < mr; ++r) {
+                size_t i = startRow + r;
+                *packed++ = i < rows ? blockA(i, k) : T();
+            }
+        }
+    }
+}
+
+template <typename T>
+void packPanelB(MatrixView<const T> blockB, int nr, T* packed) {
+    const size_t kc = blockB.rows();
+    const size_t cols = blockB.cols();
+    for (size_t startCol = 0; startCol < cols; startCol += nr) {
+        const size_t width = std::min<size_t>(nr, cols - startCol);
+        for (size_t k = 0; k < kc; ++k) {
+            const T* row = blockB.row(k) + startCol;
+            for (size_t j = 0; j < width; ++j) {
+                packed[j] = row[j];
+            }
+            for (size_t j = width; j < static_cast<size_t>(nr); ++j) {
+                packed[j] = T();
+            }
+            packed += nr;
+        }
+    }
+}
+
+template <typename T, typename Acc>
+void runMacroKernel(const GemmKernel<T, Acc>& kernel, int kc, const T* packedA, const T* packedB,
+                    MatrixView<Acc> blockC) {
+    const size_t rows = blockC.rows();
+    const size_t cols = blockC.cols();
+
+    thread_local Matrix<Acc> edgeTile;
+    if (edgeTile.rows() < static_cast<size_t>(kernel.mr) || edgeTile.cols() < static_cast<size_t>(kernel.nr)) {
+        edgeTile = Matrix<Acc>(kernel.mr, kernel.nr);
+    }
+
+    for (size_t startCol = 0; startCol < cols; startCol += kernel.nr) {
+        const T* sliverB = packedB + startCol * kc;
+        const size_t width = std::min<size_t>(kernel.nr, cols - startCol);
+        for (size_t startRow = 0; startRow < rows; startRow += kernel.mr) {
+            const T* sliverA = packedA + startRow * kc;
+            const size_t height = std::min<size_t>(kernel.mr, rows - startRow);
+            if (height == static_cast<size_t>(kernel.mr) && width == static_cast<size_t>(kernel.nr)) {
+                kernel.compute(kc, sliverA, sliverB, blockC.row(startRow) + startCol, blockC.stride());
+                continue;
+            }
+            edgeTile.fill(Acc());
+            kernel.compute(kc, sliverA, sliverB, edgeTile.data(), edgeTile.stride());
+            for (size_t i = 0; i < height; ++i) {
+                for (size_t j = 0; j < width; ++j) {
+                    blockC(startRow + i, startCol + j) += edgeTile(i, j);
+                }
+            }
+        }
+    }
+}
+
+template <typename T, typename Acc>
+void multiplyTilePacked(const GemmKernel<T, Acc>& kernel, MatrixView<const T> tileA,
+                        MatrixView<const T> tileB, MatrixView<Acc> tileC) {
+    const size_t rows = tileC.rows();
+    const size_t cols = tileC.cols();
+    const int kc = static_cast<int>(tileA.cols());
+    if (rows == 0 || cols == 0 || kc == 0) {
+        return;
+    }
+
+    const size_t paddedRows = (rows + kernel.mr - 1) / kernel.mr * kernel.mr;
+    const size_t paddedCols = (cols + kernel.nr - 1) / kernel.nr * kernel.nr;
+
+    // Packing buffers are reused by every task a worker runs.
+    thread_local Matrix<T> packedA;
+    thread_local Matrix<T> packedB;
+    if (packedA.cols() < paddedRows * kc) {
+        packedA = Matrix<T>(1, paddedRows * kc);
+    }
+    if (packedB.cols() < paddedCols * kc) {
+        packedB = Matrix<T>(1, paddedCols * kc);
+    }
+
+    packPanelA(tileA, kernel.mr, packedA.data());
+    packPanelB(tileB, kernel.nr, packedB.data());
+    runMacroKernel(kernel, kc, packedA.data(), packedB.data(), tileC);
+}
+
+#define INSTANTIATE_GEMM_KERNEL(T, Acc)                                                                         \
+    template const GemmKernel<T, Acc>& selectGemmKernel<T, Acc>(const std::string&);                           \
+    template std::vector<const GemmKernel<T, Acc>*> supportedGemmKernels<T, Acc>();                            \
+    template void runMacroKernel<T, Acc>(const GemmKernel<T, Acc>&, int, const T*, const T*, MatrixView<Acc>); \
+    template void multiplyTilePacked<T, Acc>(const GemmKernel<T, Acc>&, MatrixView<const T>,                   \
+                                             MatrixView<const T>, MatrixView<Acc>);
+
+template void packPanelA<int>(MatrixView<const int>, int, int*);
+template void packPanelA<float>(MatrixView<const float>, int, float*);
+template void packPanelA<double>(MatrixView<const double>, int, double*);
+template void packPanelB<int>(MatrixView<const int>, int, int*);
+template void packPanelB<float>(MatrixView<const float>, int, float*);
+template void packPanelB<double>(MatrixView<const double>, int, double*);
+
+INSTANTIATE_GEMM_KERNEL(int, int)
+INSTANTIATE_GEMM_KERNEL(int, int64_t)
+INSTANTIATE_GEMM_KERNEL(float, float)
+INSTANTIATE_GEMM_KERNEL(double, double)
@@ -0,0 +1,57 @@
+#ifndef GEMM_KERNEL
+#define GEMM_KERNEL
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Matrix.h"
+
+// Register-blocked micro-kernel: computes one mr x nr tile of C from an A
+// sliver (kc x mr, stored k-major) and a B sliver (kc x nr, stored k-major)
+// produced by packPanelA / packPanelB. The tile is accumulated into C.
+// T is the element type of A and B, Acc the type of C and of the sums.
+//
+// Instantiated for <int, int>, <int, int64_t>, <float, float> and
+// <double, double>; see ElementType.h.
+template <typename T, typename Acc = T>
+struct GemmKernel {
+    const char* name;
+    int mr;
+    int nr;
+    void (*compute)(int kc, const T* packedA, const T* packedB, Acc* c, size_t ldc);
+};
+
+// Returns the kernel for isa ("scalar", "sse4.1", "avx2", "avx512"), or the
+// widest one the CPU supports for "auto". Throws std::invalid_argument for
+// an unknown name and std::runtime_error when the CPU lacks the ISA. The
+// floating point avx2 kernels also need FMA.
+template <typename T, typename Acc = T>
+const GemmKernel<T, Acc>& selectGemmKernel(const std::string& isa = "auto");
+
+// Every kernel the running CPU can execute, narrowest first.
+template <typename T, typename Acc = T>
+std::vector<const GemmKernel<T, Acc>*> supportedGemmKernels();
+
+// Copies a (rows x kc) block of A into slivers of mr rows and a (kc x cols)
+// block of B into slivers of nr columns; partial slivers are zero-padded.
+// The destination must hold ceil(rows / mr) * mr * kc, resp.
+// ceil(cols / nr) * nr * kc, elements.
+template <typename T>
+void packPanelA(MatrixView<const T> blockA, int mr, T* packed);
+template <typename T>
+void packPanelB(MatrixView<const T> blockB, int nr, T* packed);
+
+// C (rows x cols) += packedA * packedB over already packed operands, as
+// produced by packPanelA / packPanelB for a shared depth kc. Edge sub-tiles
+// go through a scratch tile so the kernel never writes outside C.
+template <typename T, typename Acc>
+void runMacroKernel(const GemmKernel<T, Acc>& kernel, int kc, const T* packedA, const T* packedB,
+                    MatrixView<Acc> blockC);
+
+// tileC += tileA * tileB, packing both operands and running the kernel over
+// every mr x nr sub-tile.
+template <typename T, typename Acc>
+void multiplyTilePacked(const GemmKernel<T, Acc>& kernel, MatrixView<const T> tileA,
+                        MatrixView<const T> tileB, MatrixView<Acc> tileC);
+
+#endif // GEMM_KERNEL
@@ -0,0 +1,114 @@
+#include "GotoGemm.h"
+
+#include <unistd.h>
+#include <algorithm>
+#include <sstream>
+#include "Trace.h"
+
+namespace {
+
+long cacheSize(int name, long fallback) {
+    long size = sysconf(name);
+    return size > 0 ? size : fallback;
+}
+
+int roundDown(long value, int multiple) {
+    return static_cast<int>(std::max<long>(multiple, value / multiple * multiple));
+}
+
+int roundUp(long value, int multiple) {
+    return static_cast<int>((value + multiple - 1) / multiple * multiple);
+}
+
+} // namespace
+
+template <typename T, typename Acc>
+CacheBlocking deriveCacheBlocking(const GemmKernel<T, Acc>& kernel) {
+    const long l1 = cacheSize(_SC_LEVEL1_DCACHE_SIZE, 32 * 1024);
+    const long l2 = cacheSize(_SC_LEVEL2_CACHE_SIZE, 256 * 1024);
+    const long l3 = cacheSize(_SC_LEVEL3_CACHE_SIZE, 8 * 1024 * 1024);
+
+    // Half of each level is left for C, the other operand and the stack.
+    CacheBlocking blocking;
+    blocking.kc = roundDown(l1 / 2 / (kernel.nr * static_cast<long>(sizeof(T))), 8);
+    blocking.mc = roundDown(l2 / 2 / (blocking.kc * static_cast<long>(sizeof(T))), kernel.mr);
+    blocking.nc = roundDown(l3 / 2 / (blocking.kc * static_cast<long>(sizeof(T))), kernel.nr);
+    return blocking;
+}
+
+std::string toString(const CacheBlocking& blocking) {
+    std::ostringstream ss;
+    ss << "mc=" << blocking.mc << " kc=" << blocking.kc << " nc=" << blocking.nc;
+    return ss.str();
+}
+
+template <typename T, typename Acc>
+void multiplyGoto(const GemmKernel<T, Acc>& kernel, const CacheBlocking& blocking, ThreadPool& pool,
+                  MatrixView<const T> matrixA, MatrixView<const T> matrixB, MatrixView<Acc> resultMatrix) {
+    const int m = static_cast<int>(resultMatrix.rows());
+    const int n = static_cast<int>(resultMatrix.cols());
+    const int k = static_cast<int>(matrixA.cols());
+    const int mc = roundUp(std::max(blocking.mc, 1), kernel.mr);
+    const int kcMax = std::max(blocking.kc, 1);
+    const int ncMax = roundUp(std::max(blocking.nc, 1), kernel.nr);
+    const int workers = static_cast<int>(pool.size());
+
+    Matrix<T> packedB(1, static_cast<size_t>(std::min(ncMax, roundUp(n, kernel.nr))) * kcMax);
+
+    for (int jc = 0; jc < n; jc += ncMax) {
+        const int nc = std::min(ncMax, n - jc);
+        for (int pc = 0; pc < k; pc += kcMax) {
+            const int kc = std::min(kcMax, k - pc);
+
+            // Pack the kc x nc panel of B, split across the pool by slivers.
+            const int slivers = (nc + kernel.nr - 1) / kernel.nr;
+            const int sliversPerTask = std::max(1, (slivers + workers - 1) / workers);
+            for (int first = 0; first < slivers; first += sliversPerTask) {
+                const int startCol = first * kernel.nr;
+                const int cols = std::min(sliversPerTask * kernel.nr, nc - startCol);
+                pool.submit([&, startCol, cols, kc] {
+                    TRACE_SCOPE("goto", "pack B", jc + startCol, pc);
+                    packPanelB(matrixB.tile(pc, jc + startCol, kc, cols), kernel.nr,
+                               packedB.data() + static_cast<size_t>(startCol) * kc);
+                });
+            }
+            pool.wait();
+
+            // Each task packs one mc x kc block of A and multiplies it against
+            // a range of B slivers. Columns are split further when there are
+            // fewer row blocks than workers.
+            const int rowBlocks = (m + mc - 1) / mc;
+            const int columnChunks = std::max(1, std::min(slivers, (workers + rowBlocks - 1) / rowBlocks));
+            const int chunkCols = ((slivers + columnChunks - 1) / columnChunks) * kernel.nr;
+            for (int ic = 0; ic < m; ic += mc) {
+                const int rows = std::min(mc, m - ic);
+                for (int startCol = 0; startCol < nc; startCol += chunkCols) {
+                    const int cols = std::min(chunkCols, nc - startCol);
+                    pool.submit([&, ic, rows, startCol, cols, kc] {
+                        TRACE_SCOPE("goto", "macro tile", ic, jc + startCol, pc);
+                        thread_local Matrix<T> packedA;
+                        const size_t needed = static_cast<size_t>(roundUp(rows, kernel.mr)) * kc;
+                        if (packedA.cols() < needed) {
+                            packedA = Matrix<T>(1, needed);
+                        }
+                        packPanelA(matrixA.tile(ic, pc, rows, kc), kernel.mr, packedA.data());
+                        runMacroKernel(kernel, kc, packedA.data(),
+                                       packedB.data() + static_cast<size_t>(startCol) * kc,
+                                       resultMatrix.tile(ic, jc + startCol, rows, cols));
+                    });
+                }
+            }
+            pool.wait();
+        }
+    }
+}
+
+#define INSTANTIATE_GOTO_GEMM(T, Acc)                                                                           \
+    template CacheBlocking deriveCacheBlocking<T, Acc>(const GemmKernel<T, Acc>&);                              \
+    template void multiplyGoto<T, Acc>(const GemmKernel<T, Acc>&, const CacheBlocking&, ThreadPool&,            \
+                                       MatrixView<const T>, MatrixView<const T>, MatrixView<Acc>);
+
+INSTANTIATE_GOTO_GEMM(int, int)
+INSTANTIATE_GOTO_GEMM(int, int64_t)
+INSTANTIATE_GOTO_GEMM(float, float)
+INSTANTIATE_GOTO_GEMM(double, double)
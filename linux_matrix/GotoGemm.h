@@ -0,0 +1,34 @@
+#ifndef GOTO_GEMM
+#define GOTO_GEMM
+
+#include <string>
+#include "GemmKernel.h"
+#include "Matrix.h"
+#include "ThreadPool.h"
+
+// Block sizes of the three-level Goto/BLIS loop nest:
+//   nc columns of B per L3-resident panel,
+//   kc depth per packed panel (one B sliver of kc x nr stays in L1),
+//   mc rows of A per L2-resident packed block.
+struct CacheBlocking {
+    int mc;
+    int kc;
+    int nc;
+};
+
+// Derives mc/kc/nc for kernel from the L1D/L2/L3 sizes reported by
+// sysconf(_SC_LEVEL*_CACHE_SIZE), falling back to common sizes when the
+// C library does not know them. Results are multiples of mr / nr, and the
+// panels shrink or grow with sizeof(T).
+template <typename T, typename Acc>
+CacheBlocking deriveCacheBlocking(const GemmKernel<T, Acc>& kernel);
+
+std::string toString(const CacheBlocking& blocking);
+
+// C += A * B. B panels are packed once per (jc, pc) step and shared; the
+// mc x kc blocks of A are packed by the worker that consumes them.
+template <typename T, typename Acc>
+void multiplyGoto(const GemmKernel<T, Acc>& kernel, const CacheBlocking& blocking, ThreadPool& pool,
+                  MatrixView<const T> matrixA, MatrixView<const T> matrixB, MatrixView<Acc> resultMatrix);
+
+#endif // GOTO_GEMM
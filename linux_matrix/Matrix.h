@@ -0,0 +1,149 @@
+#ifndef MATRIX_H
+#define MATRIX_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+// Non-owning window onto a row-major matrix. stride is the distance in
+// elements between the starts of two consecutive rows (the leading
+// dimension), so a view can describe a tile of a larger matrix.
+template <typename T>
+class MatrixView {
+public:
+    MatrixView() = default;
+    MatrixView(T* data, size_t rows, size_t cols, size_t stride)
+        : _data(data), _rows(rows), _cols(cols), _stride(stride) {}
+
+    // Lets a MatrixView<T> be passed where a MatrixView<const T> is expected.
+    template <typename U, typename = std::enable_if_t<std::is_same<const U, T>::value>>
+    MatrixView(const MatrixView<U>& other)
+        : _data(other.data()), _rows(other.rows()), _cols(other.cols()), _stride(other.stride()) {}
+
+    T& operator()(size_t i, size_t j) const { return _data[i * _stride + j]; }
+    T* row(size_t i) const { return _data + i * _stride; }
+    T* data() const { return _data; }
+
+    size_t rows() const { return _rows; }
+    size_t cols() const { return _cols; }
+    size_t stride() const { return _stride; }
+
+    // Sub-view starting at (row, col), clipped to the bounds of this view.
+    MatrixView tile(size_t row, size_t col, size_t rows, size_t cols) const {
+        row = std::min(row, _rows);
+        col = std::min(col, _cols);
+        return MatrixView(_data + row * _stride + col,
+                          std::min(rows, _rows - row), std::min(cols, _cols - col), _stride);
+    }
+
+private:
+    T* _data = nullptr;
+    size_t _rows = 0;
+    size_t _cols = 0;
+    size_t _stride = 0;
+};
+
+// Owning row-major matrix stored in one contiguous buffer. The buffer and
+// every row start on a 64-byte (cache line / AVX-512 register) boundary:
+// the stride is cols rounded up to a whole number of cache lines and the
+// padding columns are kept zero.
+template <typename T>
+class Matrix {
+    static_assert(std::is_trivially_copyable<T>::value, "Matrix<T> requires a trivially copyable T");
+
+public:
+    static constexpr size_t Alignment = 64;
+
+    Matrix() = default;
+    Matrix(size_t rows, size_t cols, T value = T())
+        : _rows(rows), _cols(cols), _stride(paddedStride(cols)), _data(allocate(rows * _stride)) {
+        std::memset(_data.get(), 0, rows * _stride * sizeof(T));
+        if (value != T()) {
+            fill(value);
+        }
+    }
+
+    // Allocates without touching the buffer so that the pages are placed
+    // on the NUMA node of whichever thread writes them first. Every row,
+    // padding included, must be written (e.g. by zeroRows) before use.
+    static Matrix uninitialized(size_t rows, size_t cols) { return Matrix(rows, cols, UninitializedTag()); }
+
+    Matrix(const Matrix& other)
+        : _rows(other._rows), _cols(other._cols), _stride(other._stride), _data(allocate(other._rows * other._stride)) {
+        if (other._data) {
+            std::memcpy(_data.get(), other._data.get(), _rows * _stride * sizeof(T));
+        }
+    }
+
+    Matrix& operator=(const Matrix& other) {
+        if (this != &other) {
+            Matrix copy(other);
+            *this = std::move(copy);
+        }
+        return *this;
+    }
+
+    Matrix(Matrix&&) noexcept = default;
+    Matrix& operator=(Matrix&&) noexcept = default;
+
+    T& operator()(size_t i, size_t j) { return _data.get()[i * _stride + j]; }
+    const T& operator()(size_t i, size_t j) const { return _data.get()[i * _stride + j]; }
+
+    T* row(size_t i) { return _data.get() + i * _stride; }
+    const T* row(size_t i) const { return _data.get() + i * _stride; }
+
+    T* data() { return _data.get(); }
+    const T* data() const { return _data.get(); }
+
+    size_t rows() const { return _rows; }
+    size_t cols() const { return _cols; }
+    size_t stride() const { return _stride; }
+
+    MatrixView<T> view() { return MatrixView<T>(data(), _rows, _cols, _stride); }
+    MatrixView<const T> view() const { return MatrixView<const T>(data(), _rows, _cols, _stride); }
+
+    MatrixView<T> tile(size_t row, size_t col, size_t rows, size_t cols) { return view().tile(row, col, rows, cols); }
+    MatrixView<const T> tile(size_t row, size_t col, size_t rows, size_t cols) const { return view().tile(row, col, rows, cols); }
+
+    // Zeroes rows [first, last) including their padding columns.
+    void zeroRows(size_t first, size_t last) {
+        if (first < last) {
+            std::memset(row(first), 0, (last - first) * _stride * sizeof(T));
+        }
+    }
+
+    void fill(T value) {
+        for (size_t i = 0; i < _rows; ++i) {
+            std::fill(row(i), row(i) + _cols, value);
+        }
+    }
+
+private:
+    struct UninitializedTag {};
+
+    Matrix(size_t rows, size_t cols, UninitializedTag)
+        : _rows(rows), _cols(cols), _stride(paddedStride(cols)), _data(allocate(rows * _stride)) {}
+
+    struct AlignedDelete {
+        void operator()(T* pointer) const { ::operator delete(pointer, std::align_val_t(Alignment)); }
+    };
+
+    static size_t paddedStride(size_t cols) {
+        const size_t perLine = Alignment / sizeof(T) > 0 ? Alignment / sizeof(T) : 1;
+        return (cols + perLine - 1) / perLine * perLine;
+    }
+
+    static T* allocate(size_t count) {
+        return static_cast<T*>(::operator new(std::max<size_t>(count, 1) * sizeof(T), std::align_val_t(Alignment)));
+    }
+
+    size_t _rows = 0;
+    size_t _cols = 0;
+    size_t _stride = 0;
+    std::unique_ptr<T, AlignedDelete> _data;
+};
+
+#endif // MATRIX_H
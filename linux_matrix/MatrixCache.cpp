@@ -0,0 +1,233 @@
+#include "MatrixCache.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char cacheMagic[8] = { 'L', 'M', 'X', 'C', 'A', 'C', 'H', 'E' };
+
+// Bump when the layout or the values fillRandom produces change.
+constexpr uint32_t cacheVersion = 1;
+
+struct CacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t elementSize;
+    uint32_t dtype;
+    uint32_t reserved;
+    uint64_t rows;
+    uint64_t cols;
+    uint64_t seed;
+    uint64_t checksum;
+    uint64_t unused;
+};
+
+static_assert(sizeof(CacheHeader) == 64, "cache header must stay 64 bytes");
+
+// 64-bit FNV-1a over 8-byte words with a final avalanche; strong enough to
+// catch truncation and bit rot, and fast enough to hash while copying.
+uint64_t hashBytes(const unsigned char* bytes, size_t length) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, bytes + i, 8);
+        hash = (hash ^ word) * 0x100000001b3ull;
+    }
+    for (; i < length; ++i) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+    }
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+// Row hashes folded in row order, so the result does not depend on how
+// the rows were split across workers.
+uint64_t combineRowHashes(const std::vector<uint64_t>& rowHashes) {
+    uint64_t checksum = rowHashes.size();
+    for (uint64_t rowHash : rowHashes) {
+        checksum = (checksum ^ rowHash) * 0x100000001b3ull;
+        checksum ^= checksum >> 29;
+    }
+    return checksum;
+}
+
+// Runs function(first, last) on row band w of rows on pool worker w, the
+// banding firstTouch uses.
+template <typename Function>
+void forEachWorkerBand(ThreadPool& pool, size_t rows, Function function) {
+    const size_t workers = pool.size();
+    pool.runOnEachWorker([&](int worker) {
+        function(rows * worker / workers, rows * (worker + 1) / workers);
+    });
+}
+
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+        struct stat info;
+        if (::fstat(fd, &info) == 0 && info.st_size > 0) {
+            void* data = ::mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED) {
+                _data = static_cast<const unsigned char*>(data);
+                _size = static_cast<size_t>(info.st_size);
+                // The copy reads every page once, in parallel bands.
+                ::madvise(data, _size, MADV_WILLNEED);
+            }
+        }
+        ::close(fd);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+        if (_data) {
+            ::munmap(const_cast<unsigned char*>(_data), _size);
+        }
+    }
+
+    const unsigned char* data() const { return _data; }
+    size_t size() const { return _size; }
+
+private:
+    const unsigned char* _data = nullptr;
+    size_t _size = 0;
+};
+
+void writeAll(int fd, const void* data, size_t length, const std::string& path) {
+    const char* bytes = static_cast<const char*>(data);
+    while (length > 0) {
+        ssize_t written = ::write(fd, bytes, length);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            throw std::runtime_error(path + ": " + std::strerror(errno));
+        }
+        bytes += written;
+        length -= static_cast<size_t>(written);
+    }
+}
+
+} // namespace
+
+std::string matrixCachePath(const std::string& directory, const MatrixCacheKey& key, const char* role) {
+    return directory + "/" + elementTypeName(key.type) + "-n" + std::to_string(key.size) + "-s" +
+           std::to_string(key.seed) + "-" + role + ".mat";
+}
+
+template <typename T>
+bool loadCachedMatrix(ThreadPool& pool, const std::string& path, const MatrixCacheKey& key,
+                      Matrix<T>& matrix, std::string& reason) {
+    MappedFile file(path);
+    if (!file.data()) {
+        reason = "missing";
+        return false;
+    }
+    CacheHeader header;
+    if (file.size() < sizeof(header)) {
+        reason = "truncated header";
+        return false;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    const size_t rows = matrix.rows();
+    const size_t cols = matrix.cols();
+    if (std::memcmp(header.magic, cacheMagic, sizeof(cacheMagic)) != 0 || header.version != cacheVersion) {
+        reason = "not a version " + std::to_string(cacheVersion) + " cache file";
+        return false;
+    }
+    if (header.elementSize != sizeof(T) || header.dtype != static_cast<uint32_t>(key.type) ||
+        header.seed != key.seed || header.rows != rows || header.cols != cols) {
+        reason = "written for another dtype, seed or size";
+        return false;
+    }
+    const size_t rowBytes = cols * sizeof(T);
+    if (file.size() != sizeof(header) + rows * rowBytes) {
+        reason = "truncated data";
+        return false;
+    }
+
+    const unsigned char* data = file.data() + sizeof(header);
+    std::vector<uint64_t> rowHashes(rows);
+    forEachWorkerBand(pool, rows, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i) {
+            const unsigned char* source = data + i * rowBytes;
+            T* target = matrix.row(i);
+            std::memcpy(target, source, rowBytes);
+            std::fill(target + cols, target + matrix.stride(), T());
+            rowHashes[i] = hashBytes(source, rowBytes);
+        }
+    });
+    if (combineRowHashes(rowHashes) != header.checksum) {
+        reason = "checksum mismatch";
+        return false;
+    }
+    return true;
+}
+
+template <typename T>
+void storeCachedMatrix(ThreadPool& pool, const std::string& path, const MatrixCacheKey& key, const Matrix<T>& matrix) {
+    const size_t rows = matrix.rows();
+    const size_t rowBytes = matrix.cols() * sizeof(T);
+    std::vector<uint64_t> rowHashes(rows);
+    forEachWorkerBand(pool, rows, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i) {
+            rowHashes[i] = hashBytes(reinterpret_cast<const unsigned char*>(matrix.row(i)), rowBytes);
+        }
+    });
+
+    CacheHeader header = {};
+    std::memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+    header.version = cacheVersion;
+    header.elementSize = sizeof(T);
+    header.dtype = static_cast<uint32_t>(key.type);
+    header.rows = rows;
+    header.cols = matrix.cols();
+    header.seed = key.seed;
+    header.checksum = combineRowHashes(rowHashes);
+
+    const std::string temporary = path + ".tmp." + std::to_string(::getpid());
+    int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error(temporary + ": " + std::strerror(errno));
+    }
+    try {
+        writeAll(fd, &header, sizeof(header), temporary);
+        for (size_t i = 0; i < rows; ++i) {
+            writeAll(fd, matrix.row(i), rowBytes, temporary);
+        }
+    } catch (...) {
+        ::close(fd);
+        ::unlink(temporary.c_str());
+        throw;
+    }
+    if (::close(fd) != 0 || ::rename(temporary.c_str(), path.c_str()) != 0) {
+        const std::string error = std::strerror(errno);
+        ::unlink(temporary.c_str());
+        throw std::runtime_error(path + ": " + error);
+    }
+}
+
+#define INSTANTIATE_MATRIX_CACHE(T) \
+    template bool loadCachedMatrix<T>(ThreadPool&, const std::string&, const MatrixCacheKey&, Matrix<T>&, std::string&); \
+    template void storeCachedMatrix<T>(ThreadPool&, const std::string&, const MatrixCacheKey&, const Matrix<T>&);
+
+INSTANTIATE_MATRIX_CACHE(int)
+INSTANTIATE_MATRIX_CACHE(int64_t)
+INSTANTIATE_MATRIX_CACHE(float)
+INSTANTIATE_MATRIX_CACHE(double)
@@ -0,0 +1,42 @@
+#ifndef MATRIX_CACHE_H
+#define MATRIX_CACHE_H
+
+#include <cstdint>
+#include <string>
+#include "ElementType.h"
+#include "Matrix.h"
+#include "ThreadPool.h"
+
+// On-disk cache of the benchmark inputs and of the reference product, so
+// that a sweep repeated with the same --seed skips the O(n^3) reference.
+//
+// File layout (little endian, native element representation):
+//   64-byte header: magic "LMXCACHE", version, element size, dtype, rows,
+//                   cols, seed, checksum of the data
+//   rows * cols elements, row-major without padding
+//
+// Files are written under a temporary name and renamed into place, so a
+// reader never sees a half-written file from an interrupted run.
+struct MatrixCacheKey {
+    ElementType type;
+    int size;
+    uint64_t seed;
+};
+
+// <directory>/<dtype>-n<size>-s<seed>-<role>.mat, e.g. int32-n1024-s42-ref.mat
+std::string matrixCachePath(const std::string& directory, const MatrixCacheKey& key, const char* role);
+
+// Maps the file and copies it into matrix (rows x cols, already allocated)
+// in row bands on the pool, which also first-touches the pages of an
+// uninitialized matrix. Returns false and sets reason when the file is
+// missing, belongs to another key or fails the checksum; matrix is
+// unspecified then and has to be regenerated.
+template <typename T>
+bool loadCachedMatrix(ThreadPool& pool, const std::string& path, const MatrixCacheKey& key,
+                      Matrix<T>& matrix, std::string& reason);
+
+// Throws std::runtime_error when the file cannot be written.
+template <typename T>
+void storeCachedMatrix(ThreadPool& pool, const std::string& path, const MatrixCacheKey& key, const Matrix<T>& matrix);
+
+#endif // MATRIX_CACHE_H
@@ -0,0 +1,163 @@
+#include "OutOfCore.h"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+#include "Trace.h"
+
+namespace {
+
+long long elapsedNs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+double OutOfCoreStats::ioWaitPercent() const {
+    const long long total = ioWaitNs + computeNs;
+    return total > 0 ? 100.0 * ioWaitNs / total : 0.0;
+}
+
+std::string OutOfCoreStats::describe() const {
+    std::ostringstream ss;
+    ss << "io=" << io
+       << " steps=" << steps
+       << " read_mb=" << (bytesRead >> 20)
+       << " written_mb=" << (bytesWritten >> 20)
+       << " working_set_mb=" << (workingSetBytes >> 20)
+       << " io_wait_ms=" << ioWaitNs / 1e6
+       << " compute_ms=" << computeNs / 1e6
+       << " io_wait_pct=" << ioWaitPercent();
+    return ss.str();
+}
+
+template <typename T, typename Acc>
+OutOfCoreStats multiplyOutOfCore(const GemmKernel<T, Acc>& kernel, const CacheBlocking& blocking, ThreadPool& pool,
+                                 AsyncReader& reader, unsigned prefetchDepth,
+                                 const TiledMatrixFile& fileA, const TiledMatrixFile& fileB, TiledMatrixFile& fileC) {
+    if (fileA.cols() != fileB.rows() || fileC.rows() != fileA.rows() || fileC.cols() != fileB.cols()) {
+        throw std::invalid_argument("multiplyOutOfCore: " + fileA.path() + ", " + fileB.path() + " and " +
+                                    fileC.path() + " have mismatched dimensions");
+    }
+    if (fileB.tileSize() != fileA.tileSize() || fileC.tileSize() != fileA.tileSize()) {
+        throw std::invalid_argument("multiplyOutOfCore: " + fileA.path() + ", " + fileB.path() + " and " +
+                                    fileC.path() + " need the same tile size");
+    }
+    fileA.checkElementSize(sizeof(T));
+    fileB.checkElementSize(sizeof(T));
+    fileC.checkElementSize(sizeof(Acc));
+
+    const size_t tileSize = fileA.tileSize();
+    const size_t tileElements = tileSize * tileSize;
+    const size_t blocksI = fileA.tileRows();
+    const size_t blocksJ = fileB.tileCols();
+    const size_t blocksK = fileA.tileCols();
+
+    // prefetchDepth + 1 buffer sets: the reads of the next prefetchDepth
+    // steps land in the others while one is computed.
+    const size_t sets = std::max<size_t>(prefetchDepth, 1) + 1;
+    struct Buffers {
+        Matrix<T> tileA;
+        Matrix<T> tileB;
+    };
+    std::vector<Buffers> buffers;
+    buffers.reserve(sets);
+    for (size_t set = 0; set < sets; ++set) {
+        buffers.push_back({ Matrix<T>(1, tileElements), Matrix<T>(1, tileElements) });
+    }
+    Matrix<Acc> tileC(1, tileElements);
+
+    OutOfCoreStats stats;
+    stats.io = reader.name();
+    stats.steps = blocksI * blocksJ * blocksK;
+    stats.workingSetBytes = 2 * sets * tileElements * sizeof(T) + tileElements * sizeof(Acc);
+
+    // Step s is (blockI, blockJ, blockK) with blockK running fastest; its
+    // reads are batches[s % sets] into buffers[s % sets].
+    std::vector<uint64_t> batches(sets);
+    size_t issued = 0;
+    size_t waited = 0;
+    auto issue = [&](size_t step) {
+        Buffers& target = buffers[step % sets];
+        const size_t blockK = step % blocksK;
+        const size_t blockJ = step / blocksK % blocksJ;
+        const size_t blockI = step / blocksK / blocksJ;
+        batches[step % sets] = reader.submit({
+            { fileA.fd(), target.tileA.data(), fileA.tileBytes(), fileA.tileOffset(blockI, blockK) },
+            { fileB.fd(), target.tileB.data(), fileB.tileBytes(), fileB.tileOffset(blockK, blockJ) } });
+        stats.bytesRead += fileA.tileBytes() + fileB.tileBytes();
+        ++issued;
+    };
+
+    try {
+        while (issued < std::min(sets - 1, stats.steps)) {
+            issue(issued);
+        }
+        for (size_t step = 0; step < stats.steps; ++step) {
+            const size_t blockK = step % blocksK;
+            const size_t blockJ = step / blocksK % blocksJ;
+            const size_t blockI = step / blocksK / blocksJ;
+
+            auto waitStart = std::chrono::steady_clock::now();
+            ++waited;
+            {
+                TRACE_SCOPE("ooc", "io wait", static_cast<int>(blockI), static_cast<int>(blockJ),
+                            static_cast<int>(blockK));
+                reader.wait(batches[step % sets]);
+            }
+            stats.ioWaitNs += elapsedNs(waitStart);
+            // The set computed last step is free again.
+            if (issued < stats.steps) {
+                issue(issued);
+            }
+
+            const size_t height = fileA.tileHeight(blockI);
+            const size_t depth = fileA.tileWidth(blockK);
+            const size_t width = fileB.tileWidth(blockJ);
+            MatrixView<Acc> viewC(tileC.data(), height, width, tileSize);
+            if (blockK == 0) {
+                std::fill(tileC.data(), tileC.data() + tileElements, Acc());
+            }
+            const Buffers& current = buffers[step % sets];
+            auto computeStart = std::chrono::steady_clock::now();
+            {
+                TRACE_SCOPE("ooc", "compute", static_cast<int>(blockI), static_cast<int>(blockJ),
+                            static_cast<int>(blockK));
+                multiplyGoto(kernel, blocking, pool,
+                             MatrixView<const T>(current.tileA.data(), height, depth, tileSize),
+                             MatrixView<const T>(current.tileB.data(), depth, width, tileSize), viewC);
+            }
+            stats.computeNs += elapsedNs(computeStart);
+
+            if (blockK + 1 == blocksK) {
+                auto writeStart = std::chrono::steady_clock::now();
+                TRACE_SCOPE("ooc", "write C", static_cast<int>(blockI), static_cast<int>(blockJ));
+                fileC.writeTile(blockI, blockJ, tileC.data());
+                stats.ioWaitNs += elapsedNs(writeStart);
+                stats.bytesWritten += fileC.tileBytes();
+            }
+        }
+    } catch (...) {
+        // Reads still in flight target the buffers about to be freed.
+        for (; waited < issued; ++waited) {
+            try {
+                reader.wait(batches[waited % sets]);
+            } catch (const std::exception&) {
+            }
+        }
+        throw;
+    }
+    return stats;
+}
+
+#define INSTANTIATE_OUT_OF_CORE(T, Acc) \
+    template OutOfCoreStats multiplyOutOfCore<T, Acc>(const GemmKernel<T, Acc>&, const CacheBlocking&, ThreadPool&, \
+                                                      AsyncReader&, unsigned, const TiledMatrixFile&, const TiledMatrixFile&, TiledMatrixFile&);
+
+INSTANTIATE_OUT_OF_CORE(int, int)
+INSTANTIATE_OUT_OF_CORE(int, int64_t)
+INSTANTIATE_OUT_OF_CORE(float, float)
+INSTANTIATE_OUT_OF_CORE(double, double)
@@ -0,0 +1,48 @@
+#ifndef OUT_OF_CORE_H
+#define OUT_OF_CORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "AsyncReader.h"
+#include "GemmKernel.h"
+#include "GotoGemm.h"
+#include "ThreadPool.h"
+#include "TiledMatrixFile.h"
+
+struct OutOfCoreStats {
+    const char* io = "";            // AsyncReader::name()
+    uint64_t bytesRead = 0;
+    uint64_t bytesWritten = 0;
+    long long ioWaitNs = 0;         // compute stalled on a load or on writing C
+    long long computeNs = 0;        // inside multiplyGoto
+    size_t workingSetBytes = 0;     // tile buffers, excluding the goto pack buffers
+    size_t steps = 0;               // (blockI, blockJ, blockK) products
+
+    // Share of the run spent waiting for I/O; near 100 the run is I/O
+    // bound, near 0 the prefetch hides the reads completely.
+    double ioWaitPercent() const;
+
+    // "io= steps= read_mb= written_mb= working_set_mb= io_wait_ms=
+    // compute_ms= io_wait_pct="
+    std::string describe() const;
+};
+
+// C = A * B over tiled files (C is overwritten; see TiledMatrixFile). The
+// loop nest is the (blockI, blockJ, blockK) decomposition of the blocked
+// algorithms with the file tile as the block: one C tile stays in memory
+// while the tiles A(blockI, blockK) and B(blockK, blockJ) stream past it,
+// and each product runs on the pool through multiplyGoto.
+//
+// The reads of the next prefetchDepth steps (the following k-panels of the
+// same C tile, then of the next one) are in flight on reader while the
+// current step computes, so the working set is 2 * (prefetchDepth + 1) + 1
+// tiles however large the matrices are. All three files need the same tile
+// size; A and B hold T, C holds Acc. Throws std::invalid_argument for
+// mismatched files and std::runtime_error for I/O errors.
+template <typename T, typename Acc>
+OutOfCoreStats multiplyOutOfCore(const GemmKernel<T, Acc>& kernel, const CacheBlocking& blocking, ThreadPool& pool,
+                                 AsyncReader& reader, unsigned prefetchDepth,
+                                 const TiledMatrixFile& fileA, const TiledMatrixFile& fileB, TiledMatrixFile& fileC);
+
+#endif // OUT_OF_CORE_H
@@ -0,0 +1,188 @@
+#include "PerfCounters.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+struct EventConfig {
+    uint32_t type;
+    uint64_t config;
+};
+
+// Indexed by PerfEvent.
+const EventConfig eventConfigs[perfEventCount] = {
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | PERF_COUNT_HW_CACHE_OP_READ << 8 |
+                          PERF_COUNT_HW_CACHE_RESULT_MISS << 16 },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+};
+
+const char* const eventNames[perfEventCount] = { "cycles", "instructions", "l1d_miss", "llc_miss", "branch_miss" };
+
+int openEvent(const EventConfig& event, pid_t tid) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = event.type;
+    attr.config = event.config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(::syscall(__NR_perf_event_open, &attr, tid, -1, -1, PERF_FLAG_FD_CLOEXEC));
+}
+
+std::string paranoidLevel() {
+    std::ifstream in("/proc/sys/kernel/perf_event_paranoid");
+    std::string level;
+    return in >> level ? level : "unknown";
+}
+
+} // namespace
+
+const char* perfEventName(PerfEvent event) {
+    return eventNames[static_cast<size_t>(event)];
+}
+
+PerfCounts& PerfCounts::operator+=(const PerfCounts& other) {
+    for (size_t i = 0; i < perfEventCount; ++i) {
+        values[i] += other.values[i];
+    }
+    present |= other.present;
+    return *this;
+}
+
+PerfCounts PerfCounts::dividedBy(uint64_t count) const {
+    PerfCounts result = *this;
+    for (uint64_t& value : result.values) {
+        value = count > 0 ? value / count : value;
+    }
+    return result;
+}
+
+double PerfCounts::instructionsPerCycle() const {
+    uint64_t cycles = (*this)[PerfEvent::Cycles];
+    return cycles > 0 ? static_cast<double>((*this)[PerfEvent::Instructions]) / cycles : 0.0;
+}
+
+std::string PerfCounts::describe(double flops) const {
+    std::ostringstream ss;
+    const char* separator = "";
+    auto field = [&](const std::string& name, auto value) {
+        ss << separator << name << "=" << value;
+        separator = " ";
+    };
+    if (has(PerfEvent::Cycles)) {
+        field("cycles", (*this)[PerfEvent::Cycles]);
+    }
+    if (has(PerfEvent::Instructions)) {
+        field("instructions", (*this)[PerfEvent::Instructions]);
+    }
+    if (has(PerfEvent::Cycles) && has(PerfEvent::Instructions)) {
+        field("ipc", instructionsPerCycle());
+    }
+    for (PerfEvent miss : { PerfEvent::L1dMisses, PerfEvent::LlcMisses, PerfEvent::BranchMisses }) {
+        if (has(miss) && flops > 0.0) {
+            field(std::string(perfEventName(miss)) + "_per_kflop", (*this)[miss] * 1000.0 / flops);
+        }
+    }
+    return ss.str();
+}
+
+PerfMonitor::PerfMonitor() = default;
+
+PerfMonitor::~PerfMonitor() {
+    for (const Thread& thread : _threads) {
+        for (int fd : thread.fds) {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+        }
+    }
+}
+
+void PerfMonitor::addThread(const std::string& label, pid_t tid) {
+    Thread thread = { label, {} };
+    bool opened = false;
+    int firstError = 0;
+    for (size_t i = 0; i < perfEventCount; ++i) {
+        thread.fds[i] = openEvent(eventConfigs[i], tid);
+        if (thread.fds[i] >= 0) {
+            opened = true;
+        } else if (firstError == 0) {
+            firstError = errno;
+        }
+    }
+    if (!opened && _reason.empty()) {
+        _reason = std::string("perf_event_open: ") + std::strerror(firstError) +
+                  " (kernel.perf_event_paranoid=" + paranoidLevel() + ")";
+    }
+    _threads.push_back(thread);
+}
+
+bool PerfMonitor::available() const {
+    for (const Thread& thread : _threads) {
+        for (int fd : thread.fds) {
+            if (fd >= 0) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void PerfMonitor::start() {
+    for (const Thread& thread : _threads) {
+        for (int fd : thread.fds) {
+            if (fd >= 0) {
+                ::ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ::ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+    }
+}
+
+void PerfMonitor::stop() {
+    for (const Thread& thread : _threads) {
+        for (int fd : thread.fds) {
+            if (fd >= 0) {
+                ::ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            }
+        }
+    }
+}
+
+PerfCounts PerfMonitor::read(size_t thread) const {
+    PerfCounts counts;
+    for (size_t i = 0; i < perfEventCount; ++i) {
+        const int fd = _threads[thread].fds[i];
+        // value, time enabled, time running
+        uint64_t data[3] = {};
+        if (fd < 0 || ::read(fd, data, sizeof(data)) != static_cast<ssize_t>(sizeof(data))) {
+            continue;
+        }
+        // Never scheduled while enabled: the thread did not run, which
+        // is a count of zero rather than a missing event.
+        const double scale = data[2] > 0 ? static_cast<double>(data[1]) / data[2] : 0.0;
+        counts.values[i] = static_cast<uint64_t>(data[0] * scale);
+        counts.present |= 1u << i;
+    }
+    return counts;
+}
+
+PerfCounts PerfMonitor::total() const {
+    PerfCounts sum;
+    for (size_t thread = 0; thread < _threads.size(); ++thread) {
+        sum += read(thread);
+    }
+    return sum;
+}
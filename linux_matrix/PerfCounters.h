@@ -0,0 +1,85 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+enum class PerfEvent {
+    Cycles,
+    Instructions,
+    L1dMisses,          // L1 data cache read misses
+    LlcMisses,          // last level cache misses
+    BranchMisses,
+};
+
+const size_t perfEventCount = 5;
+
+const char* perfEventName(PerfEvent event);
+
+// User-space counts of one thread or a sum of threads. An event the kernel
+// or the CPU does not provide is missing rather than zero.
+struct PerfCounts {
+    std::array<uint64_t, perfEventCount> values{};
+    unsigned present = 0;       // bit i set when event i was counted
+
+    bool has(PerfEvent event) const { return present & (1u << static_cast<int>(event)); }
+    uint64_t operator[](PerfEvent event) const { return values[static_cast<size_t>(event)]; }
+
+    PerfCounts& operator+=(const PerfCounts& other);
+    PerfCounts dividedBy(uint64_t count) const;
+
+    double instructionsPerCycle() const;
+
+    // "cycles= instructions= ipc= l1d_miss_per_kflop= llc_miss_per_kflop=
+    // branch_miss_per_kflop=", leaving out what is missing. flops is the
+    // work the counts cover (2 * n^3 for one product).
+    std::string describe(double flops) const;
+};
+
+// Counts cycles, instructions, L1D/LLC misses and branch misses on a set of
+// threads of this process through perf_event_open, user space only so that
+// the default perf_event_paranoid of 2 allows it. Each event is opened on
+// its own, so one the CPU lacks (common in VMs) leaves the others working;
+// counts are scaled when the kernel had to multiplex them. When no counter
+// can be opened (no PMU, seccomp, perf_event_paranoid of 3) the monitor is
+// unavailable and every operation is a no-op.
+class PerfMonitor {
+public:
+    PerfMonitor();
+    ~PerfMonitor();
+
+    PerfMonitor(const PerfMonitor&) = delete;
+    PerfMonitor& operator=(const PerfMonitor&) = delete;
+
+    // Opens the counters on thread tid (see currentThreadId()), stopped.
+    void addThread(const std::string& label, pid_t tid);
+
+    bool available() const;
+
+    // Why nothing could be counted, e.g. "perf_event_open: Permission
+    // denied (kernel.perf_event_paranoid=3)".
+    const std::string& unavailableReason() const { return _reason; }
+
+    // Zeroes and starts every counter; stop() freezes them for reading.
+    void start();
+    void stop();
+
+    size_t threadCount() const { return _threads.size(); }
+    const std::string& label(size_t thread) const { return _threads[thread].label; }
+    PerfCounts read(size_t thread) const;
+    PerfCounts total() const;
+
+private:
+    struct Thread {
+        std::string label;
+        std::array<int, perfEventCount> fds;
+    };
+
+    std::vector<Thread> _threads;
+    std::string _reason;
+};
+
+#endif // PERF_COUNTERS_H
@@ -0,0 +1,104 @@
+#include "RandomFill.h"
+
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+
+namespace {
+
+constexpr uint32_t philoxM0 = 0xD2511F53;
+constexpr uint32_t philoxM1 = 0xCD9E8D57;
+constexpr uint32_t philoxW0 = 0x9E3779B9;
+constexpr uint32_t philoxW1 = 0xBB67AE85;
+constexpr int philoxRounds = 10;
+
+// Maps 32 random bits onto the requested range. The integer case uses a
+// multiply-shift instead of a modulo; its bias is below 2^-32 * range.
+template <typename T>
+T scaleToRange(uint32_t bits, T minValue, T maxValue) {
+    if constexpr (std::is_integral<T>::value) {
+        const uint64_t range = static_cast<uint64_t>(static_cast<int64_t>(maxValue) - minValue) + 1;
+        return static_cast<T>(minValue + static_cast<int64_t>((bits * range) >> 32));
+    } else {
+        const T unit = static_cast<T>(bits * (1.0 / 4294967296.0));
+        // Rounding of the scaled value may reach maxValue itself for float.
+        return std::min(minValue + (maxValue - minValue) * unit, std::nextafter(maxValue, minValue));
+    }
+}
+
+std::array<uint32_t, 4> counterFor(uint64_t block, uint64_t stream) {
+    return { static_cast<uint32_t>(block), static_cast<uint32_t>(block >> 32),
+             static_cast<uint32_t>(stream), static_cast<uint32_t>(stream >> 32) };
+}
+
+std::array<uint32_t, 2> keyFor(uint64_t seed) {
+    return { static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32) };
+}
+
+// Writes count values of the stream starting at index to target.
+template <typename T>
+void fillRun(T* target, size_t count, uint64_t index, const std::array<uint32_t, 2>& key, uint64_t stream,
+             T minValue, T maxValue) {
+    // One Philox call yields the four values of an aligned group of
+    // indices; a run may start and end in the middle of a group.
+    size_t j = 0;
+    while (j < count) {
+        const std::array<uint32_t, 4> bits = philox4x32(counterFor(index / 4, stream), key);
+        for (size_t lane = index % 4; lane < 4 && j < count; ++lane, ++j, ++index) {
+            target[j] = scaleToRange(bits[lane], minValue, maxValue);
+        }
+    }
+}
+
+} // namespace
+
+std::array<uint32_t, 4> philox4x32(std::array<uint32_t, 4> counter, std::array<uint32_t, 2> key) {
+    for (int round = 0; round < philoxRounds; ++round) {
+        const uint64_t product0 = static_cast<uint64_t>(philoxM0) * counter[0];
+        const uint64_t product1 = static_cast<uint64_t>(philoxM1) * counter[2];
+        counter = { static_cast<uint32_t>(product1 >> 32) ^ counter[1] ^ key[0], static_cast<uint32_t>(product1),
+                    static_cast<uint32_t>(product0 >> 32) ^ counter[3] ^ key[1], static_cast<uint32_t>(product0) };
+        key[0] += philoxW0;
+        key[1] += philoxW1;
+    }
+    return counter;
+}
+
+uint32_t philoxValue(uint64_t seed, uint64_t stream, uint64_t index) {
+    return philox4x32(counterFor(index / 4, stream), keyFor(seed))[index % 4];
+}
+
+template <typename T>
+void fillRandom(ThreadPool& pool, Matrix<T>& matrix, uint64_t seed, uint64_t stream, T minValue, T maxValue) {
+    const std::array<uint32_t, 2> key = keyFor(seed);
+    const size_t rows = matrix.rows();
+    const size_t cols = matrix.cols();
+    const size_t workers = pool.size();
+    pool.runOnEachWorker([&](int worker) {
+        const size_t first = rows * worker / workers;
+        const size_t last = rows * (worker + 1) / workers;
+        for (size_t i = first; i < last; ++i) {
+            T* row = matrix.row(i);
+            fillRun(row, cols, static_cast<uint64_t>(i) * cols, key, stream, minValue, maxValue);
+            std::fill(row + cols, row + matrix.stride(), T());
+        }
+    });
+}
+
+template <typename T>
+void fillRandomBlock(MatrixView<T> block, size_t firstRow, size_t firstCol, size_t matrixCols,
+                     uint64_t seed, uint64_t stream, T minValue, T maxValue) {
+    const std::array<uint32_t, 2> key = keyFor(seed);
+    for (size_t i = 0; i < block.rows(); ++i) {
+        fillRun(block.row(i), block.cols(), static_cast<uint64_t>(firstRow + i) * matrixCols + firstCol,
+                key, stream, minValue, maxValue);
+    }
+}
+
+#define INSTANTIATE_FILL_RANDOM(T) \
+    template void fillRandom<T>(ThreadPool&, Matrix<T>&, uint64_t, uint64_t, T, T); \
+    template void fillRandomBlock<T>(MatrixView<T>, size_t, size_t, size_t, uint64_t, uint64_t, T, T);
+
+INSTANTIATE_FILL_RANDOM(int)
+INSTANTIATE_FILL_RANDOM(float)
+INSTANTIATE_FILL_RANDOM(double)
@@ -0,0 +1,33 @@
+#ifndef RANDOM_FILL_H
+#define RANDOM_FILL_H
+
+#include <array>
+#include <cstdint>
+#include "Matrix.h"
+#include "ThreadPool.h"
+
+// Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2,
+// 3"): a keyed bijection of a 128-bit counter. Any element of a stream can
+// be computed directly from its index, so a fill split across any number of
+// workers produces the same values.
+std::array<uint32_t, 4> philox4x32(std::array<uint32_t, 4> counter, std::array<uint32_t, 2> key);
+
+// The index-th 32-bit value of stream under seed.
+uint32_t philoxValue(uint64_t seed, uint64_t stream, uint64_t index);
+
+// Fills matrix with values derived from (seed, stream, row * cols + col):
+// integers in [minValue, maxValue], floating point values in
+// [minValue, maxValue). Row band w goes to pool worker w, as in a
+// first-touch pass, so a matrix from Matrix::uninitialized ends up placed
+// next to the workers that filled it.
+template <typename T>
+void fillRandom(ThreadPool& pool, Matrix<T>& matrix, uint64_t seed, uint64_t stream, T minValue, T maxValue);
+
+// Fills block with the values fillRandom would put at rows firstRow.. and
+// columns firstCol.. of a matrix with matrixCols columns, so a matrix too
+// large for memory can be generated tile by tile.
+template <typename T>
+void fillRandomBlock(MatrixView<T> block, size_t firstRow, size_t firstCol, size_t matrixCols,
+                     uint64_t seed, uint64_t stream, T minValue, T maxValue);
+
+#endif // RANDOM_FILL_H
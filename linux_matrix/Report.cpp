@@ -0,0 +1,442 @@
+#include "Report.h"
+
+#include <unistd.h>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <istream>
+#include <map>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include "Topology.h"
+
+namespace {
+
+std::string compilerFlags() {
+#ifdef MATRIX_CXXFLAGS
+    return MATRIX_CXXFLAGS;
+#else
+    // Without the build passing its flags, record what the compiler enabled.
+    std::string flags;
+#ifdef __OPTIMIZE__
+    flags += "optimize ";
+#endif
+#ifdef __SSE4_1__
+    flags += "sse4.1 ";
+#endif
+#ifdef __AVX2__
+    flags += "avx2 ";
+#endif
+#ifdef __FMA__
+    flags += "fma ";
+#endif
+#ifdef __AVX512F__
+    flags += "avx512f ";
+#endif
+    return flags.empty() ? "unknown" : flags.substr(0, flags.size() - 1);
+#endif
+}
+
+std::string jsonEscape(const std::string& text) {
+    std::ostringstream ss;
+    for (char ch : text) {
+        switch (ch) {
+        case '"': ss << "\\\""; break;
+        case '\\': ss << "\\\\"; break;
+        case '\n': ss << "\\n"; break;
+        case '\t': ss << "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(ch) < 0x20) {
+                ss << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(ch) << std::dec;
+            } else {
+                ss << ch;
+            }
+        }
+    }
+    return ss.str();
+}
+
+std::string csvEscape(const std::string& text) {
+    if (text.find_first_of(",\"\n") == std::string::npos) {
+        return text;
+    }
+    std::string quoted = "\"";
+    for (char ch : text) {
+        quoted += ch == '"' ? "\"\"" : std::string(1, ch);
+    }
+    return quoted + "\"";
+}
+
+// Just enough JSON to read back what writeJsonReport produces.
+struct JsonValue {
+    enum Type { Null, Bool, Number, String, Array, Object } type = Null;
+    bool boolean = false;
+    double number = 0.0;
+    std::string text;
+    std::vector<JsonValue> items;
+    std::vector<std::pair<std::string, JsonValue>> members;
+
+    const JsonValue* find(const std::string& name) const {
+        for (const auto& member : members) {
+            if (member.first == name) {
+                return &member.second;
+            }
+        }
+        return nullptr;
+    }
+};
+
+class JsonParser {
+public:
+    explicit JsonParser(std::string text) : _text(std::move(text)) {}
+
+    JsonValue parseDocument() {
+        JsonValue value = parseValue();
+        skipSpace();
+        if (_pos != _text.size()) {
+            fail("trailing characters");
+        }
+        return value;
+    }
+
+private:
+    [[noreturn]] void fail(const std::string& what) const {
+        throw std::runtime_error("JSON report: " + what + " at offset " + std::to_string(_pos));
+    }
+
+    void skipSpace() {
+        while (_pos < _text.size() && std::isspace(static_cast<unsigned char>(_text[_pos]))) {
+            ++_pos;
+        }
+    }
+
+    void expect(char ch) {
+        skipSpace();
+        if (_pos >= _text.size() || _text[_pos] != ch) {
+            fail(std::string("expected '") + ch + "'");
+        }
+        ++_pos;
+    }
+
+    bool consumeSeparator() {
+        skipSpace();
+        if (_pos < _text.size() && _text[_pos] == ',') {
+            ++_pos;
+            return true;
+        }
+        return false;
+    }
+
+    bool consumeWord(const char* word) {
+        size_t length = std::char_traits<char>::length(word);
+        if (_text.compare(_pos, length, word) == 0) {
+            _pos += length;
+            return true;
+        }
+        return false;
+    }
+
+    JsonValue parseValue() {
+        skipSpace();
+        if (_pos >= _text.size()) {
+            fail("unexpected end");
+        }
+        JsonValue value;
+        char ch = _text[_pos];
+        if (ch == '{') {
+            value.type = JsonValue::Object;
+            ++_pos;
+            skipSpace();
+            if (_pos < _text.size() && _text[_pos] == '}') {
+                ++_pos;
+                return value;
+            }
+            while (true) {
+                skipSpace();
+                std::string name = parseString();
+                expect(':');
+                value.members.emplace_back(name, parseValue());
+                if (!consumeSeparator()) {
+                    break;
+                }
+            }
+            expect('}');
+        } else if (ch == '[') {
+            value.type = JsonValue::Array;
+            ++_pos;
+            skipSpace();
+            if (_pos < _text.size() && _text[_pos] == ']') {
+                ++_pos;
+                return value;
+            }
+            while (true) {
+                value.items.push_back(parseValue());
+                if (!consumeSeparator()) {
+                    break;
+                }
+            }
+            expect(']');
+        } else if (ch == '"') {
+            value.type = JsonValue::String;
+            value.text = parseString();
+        } else if (consumeWord("true")) {
+            value.type = JsonValue::Bool;
+            value.boolean = true;
+        } else if (consumeWord("false")) {
+            value.type = JsonValue::Bool;
+        } else if (consumeWord("null")) {
+            value.type = JsonValue::Null;
+        } else {
+            value.type = JsonValue::Number;
+            const char* start = _text.c_str() + _pos;
+            char* end = nullptr;
+            value.number = std::strtod(start, &end);
+            if (end == start) {
+                fail("invalid value");
+            }
+            _pos += end - start;
+        }
+        return value;
+    }
+
+    std::string parseString() {
+        if (_pos >= _text.size() || _text[_pos] != '"') {
+            fail("expected string");
+        }
+        ++_pos;
+        std::string result;
+        while (_pos < _text.size() && _text[_pos] != '"') {
+            char ch = _text[_pos++];
+            if (ch != '\\') {
+                result += ch;
+                continue;
+            }
+            if (_pos >= _text.size()) {
+                fail("unterminated escape");
+            }
+            char escaped = _text[_pos++];
+            switch (escaped) {
+            case 'n': result += '\n'; break;
+            case 't': result += '\t'; break;
+            case 'u':
+                if (_pos + 4 > _text.size()) {
+                    fail("truncated \\u escape");
+                }
+                result += static_cast<char>(std::stoi(_text.substr(_pos, 4), nullptr, 16));
+                _pos += 4;
+                break;
+            default: result += escaped; break;
+            }
+        }
+        expect('"');
+        return result;
+    }
+
+    std::string _text;
+    size_t _pos = 0;
+};
+
+double numberMember(const JsonValue& object, const char* name) {
+    const JsonValue* value = object.find(name);
+    return value && value->type == JsonValue::Number ? value->number : 0.0;
+}
+
+std::string stringMember(const JsonValue& object, const char* name) {
+    const JsonValue* value = object.find(name);
+    return value && value->type == JsonValue::String ? value->text : std::string();
+}
+
+} // namespace
+
+HostInfo collectHostInfo() {
+    HostInfo host;
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line)) {
+        if (line.compare(0, 10, "model name") == 0) {
+            size_t colon = line.find(':');
+            host.cpuModel = colon == std::string::npos ? line : line.substr(line.find_first_not_of(' ', colon + 1));
+            break;
+        }
+    }
+    if (host.cpuModel.empty()) {
+        host.cpuModel = "unknown";
+    }
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    host.cores = cores > 0 ? static_cast<unsigned>(cores) : 1;
+    host.l1dCacheBytes = sysconf(_SC_LEVEL1_DCACHE_SIZE);
+    host.l2CacheBytes = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    host.l3CacheBytes = sysconf(_SC_LEVEL3_CACHE_SIZE);
+#if defined(__clang__)
+    host.compiler = "clang " __clang_version__;
+#elif defined(__GNUC__)
+    host.compiler = "gcc " __VERSION__;
+#else
+    host.compiler = "unknown";
+#endif
+    host.compilerFlags = compilerFlags();
+    host.topology = detectTopology().describe();
+    host.placement = "none";
+    return host;
+}
+
+std::string BenchRecord::key() const {
+    std::ostringstream ss;
+    if (shape.empty()) {
+        ss << "size=" << size;
+    } else {
+        ss << "shape=" << shape;
+    }
+    ss << " threads=" << threads;
+    // Pool keys look like they did before --backends.
+    if (backend != "pool") {
+        ss << " backend=" << backend;
+    }
+    ss << " dtype=" << dtype << " algo=" << algorithm << " isa=" << isa;
+    if (blockSize > 0) {
+        ss << " k=" << blockSize;
+    }
+    return ss.str();
+}
+
+void writeJsonReport(std::ostream& out, const HostInfo& host, const std::vector<BenchRecord>& records) {
+    out << std::setprecision(10);
+    out << "{\n  \"host\": {\n"
+        << "    \"cpu_model\": \"" << jsonEscape(host.cpuModel) << "\",\n"
+        << "    \"cores\": " << host.cores << ",\n"
+        << "    \"l1d_cache_bytes\": " << host.l1dCacheBytes << ",\n"
+        << "    \"l2_cache_bytes\": " << host.l2CacheBytes << ",\n"
+        << "    \"l3_cache_bytes\": " << host.l3CacheBytes << ",\n"
+        << "    \"compiler\": \"" << jsonEscape(host.compiler) << "\",\n"
+        << "    \"compiler_flags\": \"" << jsonEscape(host.compilerFlags) << "\",\n"
+        << "    \"topology\": \"" << jsonEscape(host.topology) << "\",\n"
+        << "    \"placement\": \"" << jsonEscape(host.placement) << "\"\n"
+        << "  },\n  \"runs\": [";
+    for (size_t r = 0; r < records.size(); ++r) {
+        const BenchRecord& record = records[r];
+        out << (r == 0 ? "\n" : ",\n")
+            << "    {\"size\": " << record.size
+            << ", \"shape\": \"" << jsonEscape(record.shape) << "\""
+            << ", \"threads\": " << record.threads
+            << ", \"backend\": \"" << jsonEscape(record.backend) << "\""
+            << ", \"dtype\": \"" << jsonEscape(record.dtype) << "\""
+            << ", \"algo\": \"" << jsonEscape(record.algorithm) << "\""
+            << ", \"isa\": \"" << jsonEscape(record.isa) << "\""
+            << ", \"k\": " << record.blockSize
+            << ", \"details\": \"" << jsonEscape(record.details) << "\""
+            << ", \"median_ns\": " << record.medianNs
+            << ", \"min_ns\": " << record.minNs
+            << ", \"p95_ns\": " << record.p95Ns
+            << ", \"gops\": " << record.gops
+            << ", \"correct\": " << (record.correct ? "true" : "false")
+            << ", \"samples_ns\": [";
+        for (size_t s = 0; s < record.samplesNs.size(); ++s) {
+            out << (s == 0 ? "" : ", ") << record.samplesNs[s];
+        }
+        out << "]}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+void writeCsvReport(std::ostream& out, const HostInfo& host, const std::vector<BenchRecord>& records) {
+    out << std::setprecision(10);
+    out << "cpu_model,cores,l1d_cache_bytes,l2_cache_bytes,l3_cache_bytes,compiler,compiler_flags,topology,placement,"
+        << "size,shape,threads,backend,dtype,algo,isa,k,details,median_ns,min_ns,p95_ns,gops,correct,samples_ns\n";
+    const std::string hostColumns = csvEscape(host.cpuModel) + "," + std::to_string(host.cores) + "," +
+                                    std::to_string(host.l1dCacheBytes) + "," + std::to_string(host.l2CacheBytes) + "," +
+                                    std::to_string(host.l3CacheBytes) + "," + csvEscape(host.compiler) + "," +
+                                    csvEscape(host.compilerFlags) + "," + csvEscape(host.topology) + "," +
+                                    csvEscape(host.placement);
+    for (const BenchRecord& record : records) {
+        std::string samples;
+        for (long long sample : record.samplesNs) {
+            samples += (samples.empty() ? "" : " ") + std::to_string(sample);
+        }
+        out << hostColumns << ","
+            << record.size << "," << csvEscape(record.shape) << "," << record.threads << ","
+            << csvEscape(record.backend) << "," << csvEscape(record.dtype) << ","
+            << csvEscape(record.algorithm) << "," << csvEscape(record.isa) << ","
+            << record.blockSize << "," << csvEscape(record.details) << ","
+            << record.medianNs << "," << record.minNs << "," << record.p95Ns << ","
+            << record.gops << "," << (record.correct ? "YES" : "NO") << ","
+            << samples << "\n";
+    }
+}
+
+std::vector<BenchRecord> readJsonReport(std::istream& in) {
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    JsonValue document = JsonParser(buffer.str()).parseDocument();
+    const JsonValue* runs = document.find("runs");
+    if (!runs || runs->type != JsonValue::Array) {
+        throw std::runtime_error("JSON report: missing \"runs\" array");
+    }
+    std::vector<BenchRecord> records;
+    for (const JsonValue& run : runs->items) {
+        BenchRecord record;
+        record.size = static_cast<int>(numberMember(run, "size"));
+        record.shape = stringMember(run, "shape");
+        record.threads = static_cast<unsigned>(numberMember(run, "threads"));
+        // Reports from before --dtype only had int32 runs, and from before
+        // --backends only pool runs.
+        std::string dtype = stringMember(run, "dtype");
+        record.dtype = dtype.empty() ? "int32" : dtype;
+        std::string backend = stringMember(run, "backend");
+        record.backend = backend.empty() ? "pool" : backend;
+        record.algorithm = stringMember(run, "algo");
+        record.isa = stringMember(run, "isa");
+        record.blockSize = static_cast<int>(numberMember(run, "k"));
+        record.details = stringMember(run, "details");
+        record.medianNs = numberMember(run, "median_ns");
+        record.minNs = numberMember(run, "min_ns");
+        record.p95Ns = numberMember(run, "p95_ns");
+        record.gops = numberMember(run, "gops");
+        const JsonValue* correct = run.find("correct");
+        record.correct = correct && correct->type == JsonValue::Bool && correct->boolean;
+        if (const JsonValue* samples = run.find("samples_ns")) {
+            for (const JsonValue& sample : samples->items) {
+                record.samplesNs.push_back(static_cast<long long>(sample.number));
+            }
+        }
+        records.push_back(record);
+    }
+    return records;
+}
+
+int compareWithBaseline(const std::vector<BenchRecord>& current, const std::vector<BenchRecord>& baseline,
+                        double thresholdPercent, std::ostream& out) {
+    std::map<std::string, const BenchRecord*> baselineByKey;
+    for (const BenchRecord& record : baseline) {
+        baselineByKey[record.key()] = &record;
+    }
+
+    int regressions = 0;
+    int compared = 0;
+    for (const BenchRecord& record : current) {
+        auto found = baselineByKey.find(record.key());
+        if (found == baselineByKey.end()) {
+            continue;
+        }
+        ++compared;
+        const BenchRecord& before = *found->second;
+        double changePercent = before.medianNs > 0.0 ? (record.medianNs / before.medianNs - 1.0) * 100.0 : 0.0;
+        bool slower = changePercent > thresholdPercent;
+        bool broken = before.correct && !record.correct;
+        out << (slower || broken ? "REGRESSION " : "ok ") << record.key()
+            << " baseline_ms=" << before.medianNs / 1e6
+            << " current_ms=" << record.medianNs / 1e6
+            << " change=" << std::showpos << std::fixed << std::setprecision(1) << changePercent << "%"
+            << std::noshowpos << std::defaultfloat << std::setprecision(6)
+            << (broken ? " correct=NO" : "") << "\n";
+        if (slower || broken) {
+            ++regressions;
+        }
+    }
+    out << "compared=" << compared << " regressions=" << regressions
+        << " threshold=" << thresholdPercent << "%\n";
+    return regressions;
+}
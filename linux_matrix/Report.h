@@ -0,0 +1,59 @@
+#ifndef REPORT_H
+#define REPORT_H
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+// Machine the benchmark ran on and how the binary was built.
+struct HostInfo {
+    std::string cpuModel;
+    unsigned cores = 0;
+    long l1dCacheBytes = 0;
+    long l2CacheBytes = 0;
+    long l3CacheBytes = 0;
+    std::string compiler;
+    std::string compilerFlags;
+    std::string topology;        // Topology::describe()
+    std::string placement;       // worker placement policy of the run
+};
+
+HostInfo collectHostInfo();
+
+// One benchmarked configuration: what ran, every timed sample and the
+// summary the text output prints.
+struct BenchRecord {
+    int size = 0;
+    std::string shape;           // "MxNxK" or "COUNTxS" of non-square runs, "" otherwise
+    unsigned threads = 0;
+    std::string backend = "pool"; // --backends entry that ran the tasks
+    std::string dtype = "int32";  // elementTypeName() of the run
+    std::string algorithm;
+    std::string isa;
+    int blockSize = 0;           // 0 for algorithms without a block size
+    std::string details;         // free-form "key=value ..." extras
+    std::vector<long long> samplesNs;
+    double medianNs = 0.0;
+    double minNs = 0.0;
+    double p95Ns = 0.0;
+    double gops = 0.0;
+    bool correct = false;
+
+    // Identifies the configuration across runs for --compare.
+    std::string key() const;
+};
+
+void writeJsonReport(std::ostream& out, const HostInfo& host, const std::vector<BenchRecord>& records);
+void writeCsvReport(std::ostream& out, const HostInfo& host, const std::vector<BenchRecord>& records);
+
+// Parses a report written by writeJsonReport. Throws std::runtime_error
+// on malformed input.
+std::vector<BenchRecord> readJsonReport(std::istream& in);
+
+// Prints one line per configuration present in both runs and returns how
+// many regressed: a median slower than the baseline by more than
+// thresholdPercent, or a result that is no longer correct.
+int compareWithBaseline(const std::vector<BenchRecord>& current, const std::vector<BenchRecord>& baseline,
+                        double thresholdPercent, std::ostream& out);
+
+#endif // REPORT_H
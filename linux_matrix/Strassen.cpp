@@ -0,0 +1,244 @@
+#include "Strassen.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+namespace {
+
+// Temporaries per recursion level: S1..S4, T1..T4 and the three products
+// (M1, M6, M7) that do not go straight into a quadrant of C.
+constexpr size_t temporariesPerLevel = 11;
+
+// Row bands per worker for the parallel additions of the top level.
+constexpr size_t bandsPerWorker = 4;
+
+size_t serialScratchFor(size_t size, size_t cutoff) {
+    if (size <= cutoff) {
+        return 0;
+    }
+    size_t half = size / 2;
+    return temporariesPerLevel * half * half + serialScratchFor(half, cutoff);
+}
+
+// Integers go through the unsigned type so that overflow wraps instead of
+// being undefined.
+template <typename T>
+T addOrSubtract(T x, T y, bool subtract) {
+    if constexpr (std::is_integral<T>::value) {
+        using Unsigned = typename std::make_unsigned<T>::type;
+        Unsigned a = static_cast<Unsigned>(x);
+        Unsigned b = static_cast<Unsigned>(y);
+        return static_cast<T>(subtract ? a - b : a + b);
+    } else {
+        return subtract ? x - y : x + y;
+    }
+}
+
+// out = x + y or x - y over rows [first, last). out may alias x or y.
+template <typename T>
+void combine(MatrixView<T> out, MatrixView<const T> x, MatrixView<const T> y, bool subtract,
+             size_t first, size_t last) {
+    for (size_t i = first; i < last; ++i) {
+        const T* rowX = x.row(i);
+        const T* rowY = y.row(i);
+        T* rowOut = out.row(i);
+        for (size_t j = 0; j < out.cols(); ++j) {
+            rowOut[j] = addOrSubtract(rowX[j], rowY[j], subtract);
+        }
+    }
+}
+
+template <typename T>
+void zero(MatrixView<T> view) {
+    for (size_t i = 0; i < view.rows(); ++i) {
+        std::fill(view.row(i), view.row(i) + view.cols(), T());
+    }
+}
+
+// Quadrants and temporaries of one recursion level.
+template <typename T>
+struct Level {
+    Level(MatrixView<const T> a, MatrixView<const T> b, MatrixView<T> c, T* scratch)
+        : half(a.rows() / 2),
+          a11(a.tile(0, 0, half, half)), a12(a.tile(0, half, half, half)),
+          a21(a.tile(half, 0, half, half)), a22(a.tile(half, half, half, half)),
+          b11(b.tile(0, 0, half, half)), b12(b.tile(0, half, half, half)),
+          b21(b.tile(half, 0, half, half)), b22(b.tile(half, half, half, half)),
+          c11(c.tile(0, 0, half, half)), c12(c.tile(0, half, half, half)),
+          c21(c.tile(half, 0, half, half)), c22(c.tile(half, half, half, half)),
+          s1(temporary(scratch, 0)), s2(temporary(scratch, 1)), s3(temporary(scratch, 2)), s4(temporary(scratch, 3)),
+          t1(temporary(scratch, 4)), t2(temporary(scratch, 5)), t3(temporary(scratch, 6)), t4(temporary(scratch, 7)),
+          m1(temporary(scratch, 8)), m6(temporary(scratch, 9)), m7(temporary(scratch, 10)) {}
+
+    MatrixView<T> temporary(T* scratch, size_t index) const {
+        return MatrixView<T>(scratch + index * half * half, half, half, half);
+    }
+
+    // S1 = A21 + A22, S2 = S1 - A11, S3 = A11 - A21, S4 = A12 - S2,
+    // T1 = B12 - B11, T2 = B22 - T1, T3 = B22 - B12, T4 = T2 - B21.
+    void formOperands(size_t first, size_t last) const {
+        combine<T>(s1, a21, a22, false, first, last);
+        combine<T>(s2, s1, a11, true, first, last);
+        combine<T>(s3, a11, a21, true, first, last);
+        combine<T>(s4, a12, s2, true, first, last);
+        combine<T>(t1, b12, b11, true, first, last);
+        combine<T>(t2, b22, t1, true, first, last);
+        combine<T>(t3, b22, b12, true, first, last);
+        combine<T>(t4, t2, b21, true, first, last);
+    }
+
+    // Products as placed by the caller: M1 -> m1, M2 -> C11, M3 -> C12,
+    // M4 -> C21, M5 -> C22, M6 -> m6, M7 -> m7. Then
+    //   C11 = M1 + M2, C12 = M1 + M6 + M5 + M3,
+    //   C21 = M1 + M6 + M7 - M4, C22 = M1 + M6 + M7 + M5.
+    void formResult(size_t first, size_t last) const {
+        combine<T>(m6, m6, m1, false, first, last);        // U2 = M1 + M6
+        combine<T>(m7, m7, m6, false, first, last);        // U3 = U2 + M7
+        combine<T>(c12, c12, m6, false, first, last);
+        combine<T>(c12, c12, c22, false, first, last);     // U5 = M3 + U2 + M5
+        combine<T>(c21, m7, c21, true, first, last);       // U6 = U3 - M4
+        combine<T>(c22, c22, m7, false, first, last);      // U7 = U3 + M5
+        combine<T>(c11, c11, m1, false, first, last);      // U1 = M1 + M2
+    }
+
+    size_t half;
+    MatrixView<const T> a11, a12, a21, a22, b11, b12, b21, b22;
+    MatrixView<T> c11, c12, c21, c22;
+    MatrixView<T> s1, s2, s3, s4, t1, t2, t3, t4, m1, m6, m7;
+};
+
+} // namespace
+
+template <typename T>
+StrassenMultiplier<T>::StrassenMultiplier(const GemmKernel<T>& kernel, int size, int cutoff)
+    : _kernel(kernel), _blocking(deriveCacheBlocking(kernel)), _size(size), _cutoff(cutoff), _paddedSize(size),
+      _depth(0), _serialScratch(0) {
+    if (size < 1 || cutoff < 1) {
+        throw std::invalid_argument("StrassenMultiplier: size and cutoff must be positive");
+    }
+    // Smallest depth whose leaves fit the cutoff; pad to leaf * 2^depth.
+    int leaf = size;
+    while (leaf > cutoff) {
+        leaf = (leaf + 1) / 2;
+        ++_depth;
+    }
+    _paddedSize = leaf << _depth;
+
+    const size_t padded = static_cast<size_t>(_paddedSize);
+    size_t total = 0;
+    if (_paddedSize != _size) {
+        total += 3 * padded * padded;
+    }
+    if (_depth > 0) {
+        const size_t half = padded / 2;
+        _serialScratch = serialScratchFor(half, static_cast<size_t>(cutoff));
+        total += temporariesPerLevel * half * half + 7 * _serialScratch;
+    }
+    // Zeroed by Matrix, which is what the padding of A and B relies on.
+    _arena = Matrix<T>(1, total);
+}
+
+template <typename T>
+void StrassenMultiplier<T>::multiply(ThreadPool& pool, const Matrix<T>& matrixA, const Matrix<T>& matrixB,
+                                     Matrix<T>& resultMatrix) {
+    const size_t n = static_cast<size_t>(_size);
+    if (matrixA.rows() != n || matrixA.cols() != n || matrixB.rows() != n || matrixB.cols() != n ||
+        resultMatrix.rows() != n || resultMatrix.cols() != n) {
+        throw std::invalid_argument("StrassenMultiplier: operands must be " + std::to_string(n) + "x" + std::to_string(n));
+    }
+    if (_paddedSize == _size) {
+        multiplyTop(pool, matrixA.view(), matrixB.view(), resultMatrix.view());
+        return;
+    }
+
+    // Only the top-left n x n corner is written; the rest stays zero.
+    const size_t padded = static_cast<size_t>(_paddedSize);
+    MatrixView<T> paddedA(_arena.data(), padded, padded, padded);
+    MatrixView<T> paddedB(_arena.data() + padded * padded, padded, padded, padded);
+    MatrixView<T> paddedC(_arena.data() + 2 * padded * padded, padded, padded, padded);
+    for (size_t i = 0; i < n; ++i) {
+        std::memcpy(paddedA.row(i), matrixA.row(i), n * sizeof(T));
+        std::memcpy(paddedB.row(i), matrixB.row(i), n * sizeof(T));
+    }
+    multiplyTop(pool, paddedA, paddedB, paddedC);
+    for (size_t i = 0; i < n; ++i) {
+        std::memcpy(resultMatrix.row(i), paddedC.row(i), n * sizeof(T));
+    }
+}
+
+template <typename T>
+void StrassenMultiplier<T>::multiplyTop(ThreadPool& pool, MatrixView<const T> matrixA, MatrixView<const T> matrixB,
+                                        MatrixView<T> resultMatrix) {
+    if (_depth == 0) {
+        zero(resultMatrix);
+        multiplyGoto(_kernel, _blocking, pool, matrixA, matrixB, resultMatrix);
+        return;
+    }
+
+    const size_t padded = static_cast<size_t>(_paddedSize);
+    T* scratch = _arena.data() + (_paddedSize != _size ? 3 * padded * padded : 0);
+    const Level<T> level(matrixA, matrixB, resultMatrix, scratch);
+    T* productScratch = scratch + temporariesPerLevel * level.half * level.half;
+
+    const size_t bands = std::min(level.half, pool.size() * bandsPerWorker);
+    auto inBands = [&](void (Level<T>::*step)(size_t, size_t) const) {
+        for (size_t band = 0; band < bands; ++band) {
+            size_t first = level.half * band / bands;
+            size_t last = level.half * (band + 1) / bands;
+            pool.submit([&level, step, first, last] { (level.*step)(first, last); });
+        }
+        pool.wait();
+    };
+
+    inBands(&Level<T>::formOperands);
+
+    const MatrixView<const T> left[7] = { level.a11, level.a12, level.s4, level.a22, level.s1, level.s2, level.s3 };
+    const MatrixView<const T> right[7] = { level.b11, level.b21, level.b22, level.t4, level.t1, level.t2, level.t3 };
+    const MatrixView<T> products[7] = { level.m1, level.c11, level.c12, level.c21, level.c22, level.m6, level.m7 };
+    for (size_t p = 0; p < 7; ++p) {
+        T* taskScratch = productScratch + p * _serialScratch;
+        pool.submit([this, &left, &right, &products, p, taskScratch] {
+            multiplySerial(left[p], right[p], products[p], taskScratch);
+        });
+    }
+    pool.wait();
+
+    inBands(&Level<T>::formResult);
+}
+
+template <typename T>
+void StrassenMultiplier<T>::multiplySerial(MatrixView<const T> matrixA, MatrixView<const T> matrixB,
+                                           MatrixView<T> resultMatrix, T* scratch) const {
+    if (matrixA.rows() <= static_cast<size_t>(_cutoff)) {
+        // Leaves fit in L2; splitting the depth by kc keeps each packed B
+        // sliver in L1 as in multiplyGoto.
+        zero(resultMatrix);
+        const size_t depth = matrixA.cols();
+        const size_t kc = static_cast<size_t>(std::max(_blocking.kc, 1));
+        for (size_t pc = 0; pc < depth; pc += kc) {
+            multiplyTilePacked(_kernel, matrixA.tile(0, pc, matrixA.rows(), kc),
+                               matrixB.tile(pc, 0, kc, matrixB.cols()), resultMatrix);
+        }
+        return;
+    }
+
+    const Level<T> level(matrixA, matrixB, resultMatrix, scratch);
+    T* childScratch = scratch + temporariesPerLevel * level.half * level.half;
+    level.formOperands(0, level.half);
+    multiplySerial(level.a11, level.b11, level.m1, childScratch);
+    multiplySerial(level.a12, level.b21, level.c11, childScratch);
+    multiplySerial(level.s4, level.b22, level.c12, childScratch);
+    multiplySerial(level.a22, level.t4, level.c21, childScratch);
+    multiplySerial(level.s1, level.t1, level.c22, childScratch);
+    multiplySerial(level.s2, level.t2, level.m6, childScratch);
+    multiplySerial(level.s3, level.t3, level.m7, childScratch);
+    level.formResult(0, level.half);
+}
+
+template class StrassenMultiplier<int>;
+template class StrassenMultiplier<float>;
+template class StrassenMultiplier<double>;
@@ -0,0 +1,52 @@
+#ifndef STRASSEN_H
+#define STRASSEN_H
+
+#include <cstddef>
+#include "GemmKernel.h"
+#include "GotoGemm.h"
+#include "Matrix.h"
+#include "ThreadPool.h"
+
+// Strassen-Winograd multiplication (7 products, 15 additions per level) of
+// square n x n matrices. Below the cutoff the packed micro-kernel does the
+// work; at the top level the seven products run in parallel on the pool.
+// Integer additions wrap modulo 2^bits, the same ring the int kernels
+// compute in, so int results are bit-identical to the cubic algorithms.
+// Floating point results carry Strassen's weaker error bound, which grows
+// with the recursion depth. Operands and C share the type T; the benchmark
+// runs int64 through the int ring and widens C, exact while C fits in int.
+//
+// All temporaries, including the zero-padded copies needed when n is not
+// cutoff-sized times a power of two, live in one arena allocated by the
+// constructor; multiply() itself never allocates.
+template <typename T>
+class StrassenMultiplier {
+public:
+    StrassenMultiplier(const GemmKernel<T>& kernel, int size, int cutoff);
+
+    // C = A * B (C is overwritten). All three must be size x size.
+    void multiply(ThreadPool& pool, const Matrix<T>& matrixA, const Matrix<T>& matrixB, Matrix<T>& resultMatrix);
+
+    int size() const { return _size; }
+    int cutoff() const { return _cutoff; }
+    int paddedSize() const { return _paddedSize; }
+    int depth() const { return _depth; }       // recursion levels, 0 = plain blocked product
+    size_t arenaBytes() const { return _arena.cols() * sizeof(T); }
+
+private:
+    void multiplyTop(ThreadPool& pool, MatrixView<const T> matrixA, MatrixView<const T> matrixB,
+                     MatrixView<T> resultMatrix);
+    void multiplySerial(MatrixView<const T> matrixA, MatrixView<const T> matrixB,
+                        MatrixView<T> resultMatrix, T* scratch) const;
+
+    const GemmKernel<T>& _kernel;
+    CacheBlocking _blocking;
+    int _size;
+    int _cutoff;
+    int _paddedSize;
+    int _depth;
+    size_t _serialScratch;      // elements one top-level product needs below the top
+    Matrix<T> _arena;         // 1 x N buffer carved into views
+};
+
+#endif // STRASSEN_H
@@ -0,0 +1,133 @@
+#include "ThreadPool.h"
+
+#include <unistd.h>
+#include <stdexcept>
+#include "Topology.h"
+#include "Trace.h"
+
+namespace {
+thread_local int currentWorkerIndex = -1;
+}
+
+ThreadPool::ThreadPool(unsigned threadCount, std::vector<int> cpus) : _cpus(std::move(cpus)) {
+    if (threadCount == 0) {
+        threadCount = hardwareConcurrency();
+    }
+    _threads.reserve(threadCount);
+    for (unsigned i = 0; i < threadCount; ++i) {
+        pthread_t thread;
+        if (pthread_create(&thread, nullptr, workerMain, this) == 0) {
+            _threads.push_back(thread);
+            ++_threadsCreated;
+        }
+    }
+    if (_threads.empty()) {
+        throw std::runtime_error("ThreadPool: could not create any worker thread");
+    }
+    // Workers pin themselves; wait so pinnedWorkers() is final on return.
+    std::unique_lock<std::mutex> lock(_mutex);
+    _allDone.wait(lock, [this] { return _nextIndex == static_cast<int>(_threads.size()); });
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _taskReady.notify_all();
+    for (auto& thread : _threads) {
+        pthread_join(thread, nullptr);
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _tasks.push_back(std::move(task));
+    }
+    _taskReady.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _allDone.wait(lock, [this] { return _tasks.empty() && _busy == 0; });
+}
+
+void ThreadPool::runOnEachWorker(const std::function<void(int)>& function) {
+    // Each task holds its worker at the barrier until all of them have
+    // started, so no worker can pick up two of them.
+    const size_t count = _threads.size();
+    std::mutex barrierMutex;
+    std::condition_variable barrier;
+    size_t arrived = 0;
+    for (size_t i = 0; i < count; ++i) {
+        submit([&] {
+            {
+                std::unique_lock<std::mutex> lock(barrierMutex);
+                if (++arrived == count) {
+                    barrier.notify_all();
+                }
+                barrier.wait(lock, [&] { return arrived == count; });
+            }
+            function(workerIndex());
+        });
+    }
+    wait();
+}
+
+unsigned ThreadPool::size() const {
+    return static_cast<unsigned>(_threads.size());
+}
+
+size_t ThreadPool::threadsCreated() const {
+    return _threadsCreated;
+}
+
+unsigned ThreadPool::pinnedWorkers() const {
+    return _pinned;
+}
+
+int ThreadPool::workerIndex() {
+    return currentWorkerIndex;
+}
+
+unsigned ThreadPool::hardwareConcurrency() {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? static_cast<unsigned>(count) : 1;
+}
+
+void* ThreadPool::workerMain(void* param) {
+    static_cast<ThreadPool*>(param)->workerLoop();
+    return nullptr;
+}
+
+void ThreadPool::workerLoop() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    currentWorkerIndex = _nextIndex++;
+    if (!_cpus.empty() && pinCurrentThread(_cpus[currentWorkerIndex % _cpus.size()])) {
+        ++_pinned;
+    }
+    _allDone.notify_all();
+    TRACE_THREAD_NAME("pool worker " + std::to_string(currentWorkerIndex));
+    while (true) {
+        {
+            TRACE_SCOPE("pool", "queue wait");
+            _taskReady.wait(lock, [this] { return _stopping || !_tasks.empty(); });
+        }
+        if (_tasks.empty()) {
+            return;
+        }
+        std::function<void()> task = std::move(_tasks.front());
+        _tasks.pop_front();
+        ++_busy;
+        lock.unlock();
+
+        task();
+
+        lock.lock();
+        --_busy;
+        if (_busy == 0 && _tasks.empty()) {
+            _allDone.notify_all();
+        }
+    }
+}
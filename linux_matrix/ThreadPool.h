@@ -0,0 +1,62 @@
+#ifndef THREAD_POOL
+#define THREAD_POOL
+
+#include <pthread.h>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+// Fixed set of pthread workers pulling tasks from one shared FIFO queue.
+// Workers are created once in the constructor and live until destruction,
+// so submitting a task never costs a pthread_create.
+class ThreadPool {
+public:
+    // threadCount == 0 means one worker per online CPU. When cpus is not
+    // empty worker i is pinned to cpus[i % cpus.size()]; a CPU the kernel
+    // refuses leaves that worker unpinned.
+    explicit ThreadPool(unsigned threadCount = 0, std::vector<int> cpus = {});
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(std::function<void()> task);
+
+    // Blocks until the queue is empty and every worker is idle.
+    void wait();
+
+    // Runs function(workerIndex) exactly once on every worker and waits.
+    // Must not be called from inside a task of this pool.
+    void runOnEachWorker(const std::function<void(int)>& function);
+
+    unsigned size() const;
+    size_t threadsCreated() const;
+    unsigned pinnedWorkers() const;
+
+    // Index in [0, size()) of the pool worker running the caller, or -1
+    // when called from a thread that does not belong to a pool.
+    static int workerIndex();
+
+    static unsigned hardwareConcurrency();
+
+private:
+    static void* workerMain(void* param);
+    void workerLoop();
+
+    std::vector<pthread_t> _threads;
+    std::deque<std::function<void()>> _tasks;
+    std::mutex _mutex;
+    std::condition_variable _taskReady;
+    std::condition_variable _allDone;
+    std::vector<int> _cpus;
+    size_t _busy = 0;
+    size_t _threadsCreated = 0;
+    int _nextIndex = 0;
+    unsigned _pinned = 0;
+    bool _stopping = false;
+};
+
+#endif // THREAD_POOL
@@ -0,0 +1,108 @@
+#include "ThreadSpawner.h"
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include "ThreadPool.h"
+#include "Topology.h"
+
+namespace {
+
+thread_local int currentSlot = -1;
+
+struct SpawnedTask {
+    std::function<void()> task;
+    int slot;
+    int cpu;    // -1 = unpinned
+};
+
+void runSpawned(SpawnedTask& spawned) {
+    currentSlot = spawned.slot;
+    if (spawned.cpu >= 0) {
+        pinCurrentThread(spawned.cpu);
+    }
+    spawned.task();
+}
+
+void* pthreadMain(void* param) {
+    std::unique_ptr<SpawnedTask> spawned(static_cast<SpawnedTask*>(param));
+    runSpawned(*spawned);
+    return nullptr;
+}
+
+} // namespace
+
+template <SpawnApi Api>
+ThreadSpawner<Api>::ThreadSpawner(unsigned threadCount, std::vector<int> cpus) : _cpus(std::move(cpus)) {
+    if (threadCount == 0) {
+        threadCount = ThreadPool::hardwareConcurrency();
+    }
+    _threads.resize(threadCount);
+    _running.assign(threadCount, false);
+}
+
+template <SpawnApi Api>
+ThreadSpawner<Api>::~ThreadSpawner() {
+    wait();
+}
+
+template <SpawnApi Api>
+void ThreadSpawner<Api>::submit(std::function<void()> task) {
+    // Slots are reused round-robin, so the one to free is the oldest.
+    const size_t slot = _next;
+    _next = (_next + 1) % _threads.size();
+    if (_running[slot]) {
+        join(slot);
+    }
+    std::unique_ptr<SpawnedTask> spawned(new SpawnedTask{ std::move(task), static_cast<int>(slot),
+                                                          _cpus.empty() ? -1 : _cpus[slot % _cpus.size()] });
+    if constexpr (Api == SpawnApi::Pthread) {
+        const int error = pthread_create(&_threads[slot], nullptr, pthreadMain, spawned.get());
+        if (error != 0) {
+            throw std::runtime_error("PthreadSpawner: pthread_create failed with error " + std::to_string(error));
+        }
+        spawned.release();
+    } else {
+        _threads[slot] = std::thread([spawned = std::move(spawned)] { runSpawned(*spawned); });
+    }
+    _running[slot] = true;
+    ++_threadsCreated;
+}
+
+template <SpawnApi Api>
+void ThreadSpawner<Api>::wait() {
+    for (size_t slot = 0; slot < _threads.size(); ++slot) {
+        if (_running[slot]) {
+            join(slot);
+        }
+    }
+    _next = 0;
+}
+
+template <SpawnApi Api>
+void ThreadSpawner<Api>::join(size_t slot) {
+    if constexpr (Api == SpawnApi::Pthread) {
+        pthread_join(_threads[slot], nullptr);
+    } else {
+        _threads[slot].join();
+    }
+    _running[slot] = false;
+}
+
+template <SpawnApi Api>
+unsigned ThreadSpawner<Api>::size() const {
+    return static_cast<unsigned>(_threads.size());
+}
+
+template <SpawnApi Api>
+size_t ThreadSpawner<Api>::threadsCreated() const {
+    return _threadsCreated;
+}
+
+template <SpawnApi Api>
+int ThreadSpawner<Api>::workerIndex() {
+    return currentSlot;
+}
+
+template class ThreadSpawner<SpawnApi::Pthread>;
+template class ThreadSpawner<SpawnApi::StdThread>;
@@ -0,0 +1,66 @@
+#ifndef THREAD_SPAWNER
+#define THREAD_SPAWNER
+
+#include <pthread.h>
+#include <cstddef>
+#include <functional>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Threading backends that start one thread per task, the way the first
+// versions of the benchmark did, kept to measure what the persistent
+// ThreadPool saves. They share the part of the ThreadPool interface the
+// blocked algorithms use (submit, wait, size, workerIndex), so ThreadPool,
+// PthreadSpawner and StdThreadSpawner are interchangeable as their
+// Executor.
+enum class SpawnApi {
+    Pthread,    // pthread_create / pthread_join
+    StdThread   // std::thread
+};
+
+// At most size() tasks run at once, each on a thread of its own: submit
+// joins the oldest running thread before starting another when all slots
+// are taken. submit and wait must be called from one thread, and not from
+// inside a task.
+template <SpawnApi Api>
+class ThreadSpawner {
+public:
+    // threadCount == 0 means one slot per online CPU. When cpus is not
+    // empty the thread in slot i pins itself to cpus[i % cpus.size()].
+    explicit ThreadSpawner(unsigned threadCount = 0, std::vector<int> cpus = {});
+    ~ThreadSpawner();
+
+    ThreadSpawner(const ThreadSpawner&) = delete;
+    ThreadSpawner& operator=(const ThreadSpawner&) = delete;
+
+    // Throws std::system_error (std::thread) or std::runtime_error
+    // (pthreads) when the thread cannot be created.
+    void submit(std::function<void()> task);
+
+    // Joins every running thread.
+    void wait();
+
+    unsigned size() const;
+    size_t threadsCreated() const;
+
+    // Slot in [0, size()) of the spawned thread running the caller, or -1
+    // when called from a thread no spawner started.
+    static int workerIndex();
+
+private:
+    using Thread = std::conditional_t<Api == SpawnApi::Pthread, pthread_t, std::thread>;
+
+    void join(size_t slot);
+
+    std::vector<Thread> _threads;
+    std::vector<bool> _running;
+    std::vector<int> _cpus;
+    size_t _next = 0;
+    size_t _threadsCreated = 0;
+};
+
+using PthreadSpawner = ThreadSpawner<SpawnApi::Pthread>;
+using StdThreadSpawner = ThreadSpawner<SpawnApi::StdThread>;
+
+#endif // THREAD_SPAWNER
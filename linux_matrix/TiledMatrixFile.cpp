@@ -0,0 +1,227 @@
+#include "TiledMatrixFile.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+const char tiledMagic[8] = { 'L', 'M', 'X', 'T', 'I', 'L', 'E', 'D' };
+constexpr uint32_t tiledVersion = 1;
+
+struct TiledHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t dtype;
+    uint64_t elementSize;
+    uint64_t rows;
+    uint64_t cols;
+    uint64_t tileSize;
+    uint64_t reserved[2];
+};
+
+static_assert(sizeof(TiledHeader) == 64, "tiled header must stay 64 bytes");
+
+std::runtime_error fileError(const std::string& path, const std::string& what) {
+    return std::runtime_error(path + ": " + what);
+}
+
+std::runtime_error systemError(const std::string& path) {
+    return fileError(path, std::strerror(errno));
+}
+
+// Full-length pread / pwrite; a short count is end of file (read) or an
+// error, anything interrupted is retried.
+void readAt(int fd, void* buffer, size_t length, off_t offset, const std::string& path) {
+    char* bytes = static_cast<char*>(buffer);
+    while (length > 0) {
+        ssize_t count = ::pread(fd, bytes, length, offset);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count < 0) {
+            throw systemError(path);
+        }
+        if (count == 0) {
+            throw fileError(path, "unexpected end of file");
+        }
+        bytes += count;
+        length -= static_cast<size_t>(count);
+        offset += count;
+    }
+}
+
+void writeAt(int fd, const void* buffer, size_t length, off_t offset, const std::string& path) {
+    const char* bytes = static_cast<const char*>(buffer);
+    while (length > 0) {
+        ssize_t count = ::pwrite(fd, bytes, length, offset);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            throw systemError(path);
+        }
+        bytes += count;
+        length -= static_cast<size_t>(count);
+        offset += count;
+    }
+}
+
+} // namespace
+
+TiledMatrixFile TiledMatrixFile::create(const std::string& path, ElementType type, size_t elementSize,
+                                        size_t rows, size_t cols, size_t tileSize) {
+    if (rows == 0 || cols == 0 || tileSize == 0 || elementSize == 0) {
+        throw fileError(path, "rows, cols, tile size and element size must be positive");
+    }
+    TiledMatrixFile file;
+    file._path = path;
+    file._type = type;
+    file._elementSize = elementSize;
+    file._rows = rows;
+    file._cols = cols;
+    file._tileSize = tileSize;
+    file._fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (file._fd < 0) {
+        throw systemError(path);
+    }
+
+    TiledHeader header = {};
+    std::memcpy(header.magic, tiledMagic, sizeof(tiledMagic));
+    header.version = tiledVersion;
+    header.dtype = static_cast<uint32_t>(type);
+    header.elementSize = elementSize;
+    header.rows = rows;
+    header.cols = cols;
+    header.tileSize = tileSize;
+    writeAt(file._fd, &header, sizeof(header), 0, path);
+    if (::ftruncate(file._fd, file.tileOffset(file.tileRows() - 1, file.tileCols() - 1) + file.tileBytes()) != 0) {
+        throw systemError(path);
+    }
+    return file;
+}
+
+TiledMatrixFile TiledMatrixFile::open(const std::string& path, bool writable) {
+    TiledMatrixFile file;
+    file._path = path;
+    file._fd = ::open(path.c_str(), (writable ? O_RDWR : O_RDONLY) | O_CLOEXEC);
+    if (file._fd < 0) {
+        throw systemError(path);
+    }
+    TiledHeader header;
+    readAt(file._fd, &header, sizeof(header), 0, path);
+    if (std::memcmp(header.magic, tiledMagic, sizeof(tiledMagic)) != 0 || header.version != tiledVersion) {
+        throw fileError(path, "not a version " + std::to_string(tiledVersion) + " tiled matrix file");
+    }
+    if (header.dtype > static_cast<uint32_t>(ElementType::Double) || header.elementSize == 0 ||
+        header.rows == 0 || header.cols == 0 || header.tileSize == 0) {
+        throw fileError(path, "corrupt header");
+    }
+    file._type = static_cast<ElementType>(header.dtype);
+    file._elementSize = header.elementSize;
+    file._rows = header.rows;
+    file._cols = header.cols;
+    file._tileSize = header.tileSize;
+
+    const off_t expected = file.tileOffset(file.tileRows() - 1, file.tileCols() - 1) + file.tileBytes();
+    if (::lseek(file._fd, 0, SEEK_END) < expected) {
+        throw fileError(path, "truncated, expected " + std::to_string(expected) + " bytes");
+    }
+    return file;
+}
+
+TiledMatrixFile::TiledMatrixFile(TiledMatrixFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+TiledMatrixFile& TiledMatrixFile::operator=(TiledMatrixFile&& other) noexcept {
+    if (this != &other) {
+        if (_fd >= 0) {
+            ::close(_fd);
+        }
+        _path = std::move(other._path);
+        _fd = other._fd;
+        _type = other._type;
+        _elementSize = other._elementSize;
+        _rows = other._rows;
+        _cols = other._cols;
+        _tileSize = other._tileSize;
+        other._fd = -1;
+    }
+    return *this;
+}
+
+TiledMatrixFile::~TiledMatrixFile() {
+    if (_fd >= 0) {
+        ::close(_fd);
+    }
+}
+
+off_t TiledMatrixFile::tileOffset(size_t tileRow, size_t tileCol) const {
+    return static_cast<off_t>(sizeof(TiledHeader) + (tileRow * tileCols() + tileCol) * tileBytes());
+}
+
+void TiledMatrixFile::readTileBytes(size_t tileRow, size_t tileCol, void* buffer) const {
+    readAt(_fd, buffer, tileBytes(), tileOffset(tileRow, tileCol), _path);
+}
+
+void TiledMatrixFile::writeTileBytes(size_t tileRow, size_t tileCol, const void* buffer) {
+    writeAt(_fd, buffer, tileBytes(), tileOffset(tileRow, tileCol), _path);
+}
+
+void TiledMatrixFile::checkElementSize(size_t size) const {
+    if (size != _elementSize) {
+        throw fileError(_path, "holds " + std::to_string(_elementSize) + "-byte elements, not " +
+                               std::to_string(size) + "-byte ones");
+    }
+}
+
+template <typename T>
+void writeTiledMatrix(const std::string& path, ElementType type, const Matrix<T>& matrix, size_t tileSize) {
+    TiledMatrixFile file = TiledMatrixFile::create(path, type, sizeof(T), matrix.rows(), matrix.cols(), tileSize);
+    std::vector<T> tile(tileSize * tileSize);
+    for (size_t tileRow = 0; tileRow < file.tileRows(); ++tileRow) {
+        for (size_t tileCol = 0; tileCol < file.tileCols(); ++tileCol) {
+            std::fill(tile.begin(), tile.end(), T());
+            const size_t width = file.tileWidth(tileCol);
+            for (size_t i = 0; i < file.tileHeight(tileRow); ++i) {
+                const T* source = matrix.row(tileRow * tileSize + i) + tileCol * tileSize;
+                std::copy(source, source + width, tile.data() + i * tileSize);
+            }
+            file.writeTile(tileRow, tileCol, tile.data());
+        }
+    }
+}
+
+template <typename T>
+void readTiledMatrix(const TiledMatrixFile& file, Matrix<T>& matrix) {
+    if (matrix.rows() != file.rows() || matrix.cols() != file.cols()) {
+        throw fileError(file.path(), "holds a " + std::to_string(file.rows()) + "x" + std::to_string(file.cols()) +
+                                     " matrix");
+    }
+    const size_t tileSize = file.tileSize();
+    std::vector<T> tile(tileSize * tileSize);
+    for (size_t tileRow = 0; tileRow < file.tileRows(); ++tileRow) {
+        for (size_t tileCol = 0; tileCol < file.tileCols(); ++tileCol) {
+            file.readTile(tileRow, tileCol, tile.data());
+            const size_t width = file.tileWidth(tileCol);
+            for (size_t i = 0; i < file.tileHeight(tileRow); ++i) {
+                const T* source = tile.data() + i * tileSize;
+                std::copy(source, source + width, matrix.row(tileRow * tileSize + i) + tileCol * tileSize);
+            }
+        }
+    }
+}
+
+#define INSTANTIATE_TILED_MATRIX_FILE(T) \
+    template void writeTiledMatrix<T>(const std::string&, ElementType, const Matrix<T>&, size_t); \
+    template void readTiledMatrix<T>(const TiledMatrixFile&, Matrix<T>&);
+
+INSTANTIATE_TILED_MATRIX_FILE(int)
+INSTANTIATE_TILED_MATRIX_FILE(int64_t)
+INSTANTIATE_TILED_MATRIX_FILE(float)
+INSTANTIATE_TILED_MATRIX_FILE(double)
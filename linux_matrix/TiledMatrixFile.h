@@ -0,0 +1,95 @@
+#ifndef TILED_MATRIX_FILE_H
+#define TILED_MATRIX_FILE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <sys/types.h>
+#include "ElementType.h"
+#include "Matrix.h"
+
+// Matrix stored on disk as square tiles, for operands that do not fit in
+// memory.
+//
+// File layout (little endian, native element representation):
+//   64-byte header: magic "LMXTILED", version, dtype, element size, rows,
+//                   cols, tile size
+//   tiles in row-major tile order, each tileSize x tileSize elements,
+//   row-major; edge tiles are zero-padded to the full size
+//
+// Every tile therefore starts at a fixed offset and is read or written with
+// a single pread / pwrite. Errors throw std::runtime_error naming the file.
+class TiledMatrixFile {
+public:
+    // Creates (or truncates) path for a rows x cols matrix. The tiles read
+    // as zero until written; the file is sparse where the file system
+    // allows it.
+    static TiledMatrixFile create(const std::string& path, ElementType type, size_t elementSize,
+                                  size_t rows, size_t cols, size_t tileSize);
+
+    // Opens an existing file, read-only unless writable is set.
+    static TiledMatrixFile open(const std::string& path, bool writable = false);
+
+    TiledMatrixFile(TiledMatrixFile&& other) noexcept;
+    TiledMatrixFile& operator=(TiledMatrixFile&& other) noexcept;
+    TiledMatrixFile(const TiledMatrixFile&) = delete;
+    TiledMatrixFile& operator=(const TiledMatrixFile&) = delete;
+    ~TiledMatrixFile();
+
+    const std::string& path() const { return _path; }
+    ElementType elementType() const { return _type; }
+    size_t elementSize() const { return _elementSize; }
+    size_t rows() const { return _rows; }
+    size_t cols() const { return _cols; }
+    size_t tileSize() const { return _tileSize; }
+    size_t tileRows() const { return (_rows + _tileSize - 1) / _tileSize; }
+    size_t tileCols() const { return (_cols + _tileSize - 1) / _tileSize; }
+    size_t tileBytes() const { return _tileSize * _tileSize * _elementSize; }
+
+    // Rows resp. columns of real data in tile row / tile column index.
+    size_t tileHeight(size_t tileRow) const { return std::min(_tileSize, _rows - tileRow * _tileSize); }
+    size_t tileWidth(size_t tileCol) const { return std::min(_tileSize, _cols - tileCol * _tileSize); }
+
+    int fd() const { return _fd; }
+    off_t tileOffset(size_t tileRow, size_t tileCol) const;
+
+    // Reads / writes one whole tile (tileBytes()) at buffer.
+    void readTileBytes(size_t tileRow, size_t tileCol, void* buffer) const;
+    void writeTileBytes(size_t tileRow, size_t tileCol, const void* buffer);
+
+    template <typename T>
+    void readTile(size_t tileRow, size_t tileCol, T* buffer) const {
+        checkElementSize(sizeof(T));
+        readTileBytes(tileRow, tileCol, buffer);
+    }
+
+    template <typename T>
+    void writeTile(size_t tileRow, size_t tileCol, const T* buffer) {
+        checkElementSize(sizeof(T));
+        writeTileBytes(tileRow, tileCol, buffer);
+    }
+
+    void checkElementSize(size_t size) const;
+
+private:
+    TiledMatrixFile() = default;
+
+    std::string _path;
+    int _fd = -1;
+    ElementType _type = ElementType::Int32;
+    size_t _elementSize = 0;
+    size_t _rows = 0;
+    size_t _cols = 0;
+    size_t _tileSize = 0;
+};
+
+// Writes matrix to a new tiled file at path.
+template <typename T>
+void writeTiledMatrix(const std::string& path, ElementType type, const Matrix<T>& matrix, size_t tileSize);
+
+// Reads the whole file into matrix, which must have its dimensions.
+template <typename T>
+void readTiledMatrix(const TiledMatrixFile& file, Matrix<T>& matrix);
+
+#endif // TILED_MATRIX_FILE_H
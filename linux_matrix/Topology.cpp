@@ -0,0 +1,226 @@
+#include "Topology.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+bool readInt(const std::string& path, int& value) {
+    std::ifstream in(path);
+    return static_cast<bool>(in >> value);
+}
+
+// Parses the kernel's list format, e.g. "0-3,8,10-11".
+std::vector<int> parseCpuList(const std::string& text) {
+    std::vector<int> cpus;
+    std::stringstream ss(text);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        if (range.empty() || range == "\n") {
+            continue;
+        }
+        size_t dash = range.find('-');
+        size_t usedFirst = 0;
+        size_t usedLast = 0;
+        int first = std::stoi(range, &usedFirst);
+        int last = first;
+        if (dash != std::string::npos) {
+            last = std::stoi(range.substr(dash + 1), &usedLast);
+            usedLast += dash + 1;
+        } else {
+            usedLast = usedFirst;
+        }
+        std::string rest = range.substr(usedLast);
+        if (first < 0 || last < first || rest.find_first_not_of(" \n") != std::string::npos) {
+            throw std::invalid_argument("bad CPU range '" + range + "'");
+        }
+        for (int cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+std::string formatCpuList(const std::vector<int>& cpus) {
+    std::string text;
+    for (size_t i = 0; i < cpus.size(); ++i) {
+        text += (i == 0 ? "" : ",") + std::to_string(cpus[i]);
+    }
+    return text;
+}
+
+std::vector<int> allowedCpus() {
+    std::vector<int> cpus;
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    if (sched_getaffinity(0, sizeof(mask), &mask) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &mask)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+    if (cpus.empty()) {
+        long count = sysconf(_SC_NPROCESSORS_ONLN);
+        for (long cpu = 0; cpu < std::max(1L, count); ++cpu) {
+            cpus.push_back(static_cast<int>(cpu));
+        }
+    }
+    return cpus;
+}
+
+} // namespace
+
+std::string Topology::describe() const {
+    std::ostringstream ss;
+    ss << "nodes=" << nodeCount << " packages=" << packageCount
+       << " cores=" << coreCount << " cpus=" << cpus.size();
+    return ss.str();
+}
+
+Topology detectTopology() {
+    Topology topology;
+    std::map<int, int> nodeOfCpu;
+    for (int node = 0;; ++node) {
+        std::ifstream in("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        if (!in) {
+            break;
+        }
+        std::string list;
+        std::getline(in, list);
+        try {
+            for (int cpu : parseCpuList(list)) {
+                nodeOfCpu[cpu] = node;
+            }
+        } catch (const std::invalid_argument&) {
+            break;
+        }
+    }
+
+    std::set<int> nodes;
+    std::set<int> packages;
+    std::set<std::pair<int, int>> cores;
+    for (int cpu : allowedCpus()) {
+        const std::string base = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/";
+        CpuInfo info = { cpu, cpu, 0, 0 };
+        readInt(base + "core_id", info.core);
+        readInt(base + "physical_package_id", info.package);
+        auto node = nodeOfCpu.find(cpu);
+        info.node = node == nodeOfCpu.end() ? 0 : node->second;
+        topology.cpus.push_back(info);
+        nodes.insert(info.node);
+        packages.insert(info.package);
+        cores.insert({ info.package, info.core });
+    }
+    topology.nodeCount = static_cast<int>(std::max<size_t>(1, nodes.size()));
+    topology.packageCount = static_cast<int>(std::max<size_t>(1, packages.size()));
+    topology.coreCount = static_cast<int>(std::max<size_t>(1, cores.size()));
+    return topology;
+}
+
+std::string Placement::describe() const {
+    switch (policy) {
+    case PlacementPolicy::None: return "none";
+    case PlacementPolicy::Compact: return "compact";
+    case PlacementPolicy::Scatter: return "scatter";
+    case PlacementPolicy::List: return "list:" + formatCpuList(cpuList);
+    }
+    return "?";
+}
+
+Placement parsePlacement(const std::string& text) {
+    Placement placement;
+    if (text == "none") {
+        placement.policy = PlacementPolicy::None;
+    } else if (text == "compact") {
+        placement.policy = PlacementPolicy::Compact;
+    } else if (text == "scatter") {
+        placement.policy = PlacementPolicy::Scatter;
+    } else {
+        placement.policy = PlacementPolicy::List;
+        try {
+            placement.cpuList = parseCpuList(text);
+        } catch (const std::exception&) {
+            placement.cpuList.clear();
+        }
+        if (placement.cpuList.empty()) {
+            throw std::invalid_argument("--placement: expected none, compact, scatter or a CPU list, got '" + text + "'");
+        }
+    }
+    return placement;
+}
+
+std::vector<int> assignCpus(const Topology& topology, const Placement& placement, unsigned workerCount) {
+    std::vector<int> order;
+    if (placement.policy == PlacementPolicy::None || topology.cpus.empty()) {
+        return order;
+    }
+
+    if (placement.policy == PlacementPolicy::List) {
+        order = placement.cpuList;
+    } else {
+        std::vector<CpuInfo> cpus = topology.cpus;
+        std::sort(cpus.begin(), cpus.end(), [](const CpuInfo& a, const CpuInfo& b) {
+            if (a.node != b.node) return a.node < b.node;
+            if (a.package != b.package) return a.package < b.package;
+            if (a.core != b.core) return a.core < b.core;
+            return a.cpu < b.cpu;
+        });
+        if (placement.policy == PlacementPolicy::Compact) {
+            for (const CpuInfo& info : cpus) {
+                order.push_back(info.cpu);
+            }
+        } else {
+            // Per node: first hardware thread of every core, then siblings.
+            std::map<int, std::vector<int>> perNode;
+            std::map<int, std::set<std::pair<int, int>>> usedCores;
+            std::vector<CpuInfo> siblings;
+            for (const CpuInfo& info : cpus) {
+                if (usedCores[info.node].insert({ info.package, info.core }).second) {
+                    perNode[info.node].push_back(info.cpu);
+                } else {
+                    siblings.push_back(info);
+                }
+            }
+            for (const CpuInfo& info : siblings) {
+                perNode[info.node].push_back(info.cpu);
+            }
+            // Round-robin across nodes.
+            for (size_t i = 0; order.size() < cpus.size(); ++i) {
+                for (auto& node : perNode) {
+                    if (i < node.second.size()) {
+                        order.push_back(node.second[i]);
+                    }
+                }
+            }
+        }
+    }
+
+    std::vector<int> assigned;
+    for (unsigned i = 0; i < workerCount; ++i) {
+        assigned.push_back(order[i % order.size()]);
+    }
+    return assigned;
+}
+
+bool pinCurrentThread(int cpu) {
+    if (cpu < 0 || cpu >= CPU_SETSIZE) {
+        return false;
+    }
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    CPU_SET(cpu, &mask);
+    return pthread_setaffinity_np(pthread_self(), sizeof(mask), &mask) == 0;
+}
+
+pid_t currentThreadId() {
+    return static_cast<pid_t>(::syscall(SYS_gettid));
+}
@@ -0,0 +1,58 @@
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+
+#include <sys/types.h>
+#include <string>
+#include <vector>
+
+// One logical CPU the process may run on, as described by
+// /sys/devices/system/cpu/cpuN/topology and /sys/devices/system/node.
+struct CpuInfo {
+    int cpu;
+    int core;
+    int package;
+    int node;
+};
+
+struct Topology {
+    std::vector<CpuInfo> cpus;   // only CPUs in the process affinity mask
+    int nodeCount = 1;
+    int packageCount = 1;
+    int coreCount = 1;
+
+    std::string describe() const;
+};
+
+// Reads the CPU/NUMA layout from sysfs. Without sysfs every allowed CPU is
+// reported as its own core on node 0, which keeps placement usable.
+Topology detectTopology();
+
+enum class PlacementPolicy {
+    None,       // leave scheduling to the kernel
+    Compact,    // fill a core, then the next core of the same node
+    Scatter,    // spread across nodes first, then across physical cores
+    List        // explicit CPU list
+};
+
+struct Placement {
+    PlacementPolicy policy = PlacementPolicy::None;
+    std::vector<int> cpuList;    // for PlacementPolicy::List
+
+    std::string describe() const;
+};
+
+// Accepts "none", "compact", "scatter" or a CPU list such as "0,2,4-7".
+// Throws std::invalid_argument otherwise.
+Placement parsePlacement(const std::string& text);
+
+// CPU for each of workerCount workers (wrapping when there are more
+// workers than CPUs), or an empty vector for PlacementPolicy::None.
+std::vector<int> assignCpus(const Topology& topology, const Placement& placement, unsigned workerCount);
+
+// Pins the calling thread to cpu; returns false if the kernel refused.
+bool pinCurrentThread(int cpu);
+
+// Kernel id of the calling thread (gettid), as perf_event_open takes it.
+pid_t currentThreadId();
+
+#endif // TOPOLOGY_H
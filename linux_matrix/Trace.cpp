@@ -0,0 +1,229 @@
+#include "Trace.h"
+
+#include <ostream>
+
+#if MATRIX_TRACE
+
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "Topology.h"
+
+namespace {
+
+struct TraceEvent {
+    const char* category;
+    const char* name;
+    uint64_t startNs;
+    uint64_t durationNs;
+    int args[3];
+    int argCount;
+};
+
+// Written only by its thread; read by writeChromeTrace once the thread is
+// idle.
+struct ThreadTrace {
+    pid_t threadId = 0;
+    std::string name;
+    std::unique_ptr<TraceEvent[]> events;
+    std::atomic<uint64_t> written{ 0 };
+};
+
+// The events of a thread that has exited, oldest first. Only these are
+// kept, so a thread that records a few events before exiting costs a few
+// events, not a ring buffer.
+struct FinishedTrace {
+    pid_t threadId;
+    std::string name;
+    std::vector<TraceEvent> events;
+    uint64_t dropped;
+};
+
+struct TraceRegistry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadTrace>> threads;     // running threads
+    std::vector<FinishedTrace> finished;                    // in the order they exited
+    std::vector<std::unique_ptr<TraceEvent[]>> spareBuffers; // of exited threads, for new ones
+    const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+};
+
+TraceRegistry& registry() {
+    static TraceRegistry instance;
+    return instance;
+}
+
+// Registers the buffer of its thread on the first event and hands the
+// events to the registry when the thread exits.
+class TraceHolder {
+public:
+    ~TraceHolder() {
+        if (_trace) {
+            finish();
+        }
+    }
+
+    ThreadTrace& trace() {
+        if (!_trace) {
+            TraceRegistry& traces = registry();
+            std::lock_guard<std::mutex> lock(traces.mutex);
+            std::unique_ptr<ThreadTrace> trace(new ThreadTrace);
+            if (traces.spareBuffers.empty()) {
+                trace->events.reset(new TraceEvent[traceBufferEvents]);
+            } else {
+                trace->events = std::move(traces.spareBuffers.back());
+                traces.spareBuffers.pop_back();
+            }
+            trace->threadId = currentThreadId();
+            traces.threads.push_back(std::move(trace));
+            _trace = traces.threads.back().get();
+        }
+        return *_trace;
+    }
+
+private:
+    void finish() {
+        TraceRegistry& traces = registry();
+        std::lock_guard<std::mutex> lock(traces.mutex);
+        const uint64_t written = _trace->written.load(std::memory_order_relaxed);
+        const uint64_t first = written > traceBufferEvents ? written - traceBufferEvents : 0;
+        FinishedTrace finished = { _trace->threadId, std::move(_trace->name), {}, first };
+        finished.events.reserve(written - first);
+        for (uint64_t index = first; index < written; ++index) {
+            finished.events.push_back(_trace->events[index % traceBufferEvents]);
+        }
+        traces.finished.push_back(std::move(finished));
+        traces.spareBuffers.push_back(std::move(_trace->events));
+        for (auto it = traces.threads.begin(); it != traces.threads.end(); ++it) {
+            if (it->get() == _trace) {
+                traces.threads.erase(it);
+                break;
+            }
+        }
+        _trace = nullptr;
+    }
+
+    ThreadTrace* _trace = nullptr;
+};
+
+thread_local TraceHolder currentTrace;
+
+ThreadTrace& threadTrace() {
+    return currentTrace.trace();
+}
+
+uint64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() -
+                                                                registry().epoch).count();
+}
+
+// Chrome wants microseconds; the nanoseconds stay as decimals.
+void writeMicroseconds(std::ostream& out, uint64_t ns) {
+    out << ns / 1000 << '.' << std::setw(3) << std::setfill('0') << ns % 1000 << std::setfill(' ');
+}
+
+void writeEscaped(std::ostream& out, const std::string& text) {
+    out << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out << '\\';
+        }
+        out << c;
+    }
+    out << '"';
+}
+
+void writeThread(std::ostream& out, pid_t processId, pid_t threadId, const std::string& name,
+                 const TraceEvent* events, size_t count, const char*& separator) {
+    static const char* const argNames[3] = { "i", "j", "k" };
+    if (!name.empty()) {
+        out << separator << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": " << processId
+            << ", \"tid\": " << threadId << ", \"args\": {\"name\": ";
+        writeEscaped(out, name);
+        out << "}}";
+        separator = ",\n";
+    }
+    for (size_t index = 0; index < count; ++index) {
+        const TraceEvent& event = events[index];
+        out << separator << "{\"name\": \"" << event.name << "\", \"cat\": \"" << event.category
+            << "\", \"ph\": \"X\", \"pid\": " << processId << ", \"tid\": " << threadId << ", \"ts\": ";
+        writeMicroseconds(out, event.startNs);
+        out << ", \"dur\": ";
+        writeMicroseconds(out, event.durationNs);
+        if (event.argCount > 0) {
+            out << ", \"args\": {";
+            for (int arg = 0; arg < event.argCount; ++arg) {
+                out << (arg > 0 ? ", " : "") << "\"" << argNames[arg] << "\": " << event.args[arg];
+            }
+            out << "}";
+        }
+        out << "}";
+        separator = ",\n";
+    }
+}
+
+} // namespace
+
+TraceScope::TraceScope(const char* category, const char* name, std::initializer_list<int> args)
+    : _category(category), _name(name), _startNs(nowNs()), _args{}, _argCount(0) {
+    for (int arg : args) {
+        if (_argCount < 3) {
+            _args[_argCount++] = arg;
+        }
+    }
+}
+
+TraceScope::~TraceScope() {
+    const uint64_t endNs = nowNs();
+    ThreadTrace& trace = threadTrace();
+    const uint64_t index = trace.written.load(std::memory_order_relaxed);
+    TraceEvent& event = trace.events[index % traceBufferEvents];
+    event = { _category, _name, _startNs, endNs - _startNs, { _args[0], _args[1], _args[2] }, _argCount };
+    trace.written.store(index + 1, std::memory_order_release);
+}
+
+void traceThreadName(const std::string& name) {
+    threadTrace().name = name;
+}
+
+size_t writeChromeTrace(std::ostream& out) {
+    TraceRegistry& traces = registry();
+    std::lock_guard<std::mutex> lock(traces.mutex);
+    const pid_t processId = ::getpid();
+    size_t count = 0;
+    uint64_t dropped = 0;
+    const char* separator = "\n";
+    out << "{\"traceEvents\": [";
+    for (const FinishedTrace& trace : traces.finished) {
+        writeThread(out, processId, trace.threadId, trace.name, trace.events.data(), trace.events.size(), separator);
+        count += trace.events.size();
+        dropped += trace.dropped;
+    }
+    // The ring of a running thread is written in two parts, oldest first.
+    for (const auto& trace : traces.threads) {
+        const uint64_t written = trace->written.load(std::memory_order_acquire);
+        const uint64_t first = written > traceBufferEvents ? written - traceBufferEvents : 0;
+        const size_t start = static_cast<size_t>(first % traceBufferEvents);
+        const size_t total = static_cast<size_t>(written - first);
+        const size_t head = std::min(total, traceBufferEvents - start);
+        writeThread(out, processId, trace->threadId, trace->name, trace->events.get() + start, head, separator);
+        writeThread(out, processId, trace->threadId, std::string(), trace->events.get(), total - head, separator);
+        count += total;
+        dropped += first;
+    }
+    out << "\n], \"displayTimeUnit\": \"ns\", \"otherData\": {\"dropped_events\": " << dropped << "}}\n";
+    return count;
+}
+
+#else
+
+size_t writeChromeTrace(std::ostream& out) {
+    out << "{\"traceEvents\": []}\n";
+    return 0;
+}
+
+#endif // MATRIX_TRACE
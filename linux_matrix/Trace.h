@@ -0,0 +1,85 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iosfwd>
+#include <string>
+
+// Timeline tracing of tasks, lock waits and queue waits, written as Chrome
+// trace_event JSON (open it in Perfetto or chrome://tracing). Build with
+// -DMATRIX_TRACE=1 to compile it in; otherwise every TRACE_ macro expands
+// to nothing and its arguments are not evaluated.
+//
+// Each thread records into its own ring buffer, so recording takes no
+// lock; only the first event of a thread registers its buffer. A buffer
+// keeps the newest traceBufferEvents events of its thread. When the thread
+// exits its events are copied out and the buffer goes to the next thread
+// that records, so threads started per task cost only their events.
+#ifndef MATRIX_TRACE
+#define MATRIX_TRACE 0
+#endif
+
+const bool tracingCompiledIn = MATRIX_TRACE != 0;
+
+const size_t traceBufferEvents = size_t(1) << 15;
+
+#if MATRIX_TRACE
+
+// Records [construction, destruction) as one event of the calling thread.
+// category and name must be string literals (only the pointers are kept);
+// up to three integer arguments are shown as i, j and k.
+class TraceScope {
+public:
+    TraceScope(const char* category, const char* name, std::initializer_list<int> args);
+    ~TraceScope();
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* _category;
+    const char* _name;
+    uint64_t _startNs;
+    int _args[3];
+    int _argCount;
+};
+
+// Names the calling thread in the trace.
+void traceThreadName(const std::string& name);
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(category, name, ...) \
+    TraceScope TRACE_CONCAT(traceScope, __LINE__)(category, name, { __VA_ARGS__ })
+#define TRACE_THREAD_NAME(name) traceThreadName(name)
+
+#else
+
+#define TRACE_SCOPE(...) static_cast<void>(0)
+#define TRACE_THREAD_NAME(name) static_cast<void>(0)
+
+#endif // MATRIX_TRACE
+
+// Locks mutex, recording the time spent blocked when another thread holds
+// it. An uncontended lock records nothing.
+template <typename Mutex>
+void lockTraced(Mutex& mutex, const char* name) {
+#if MATRIX_TRACE
+    if (mutex.try_lock()) {
+        return;
+    }
+    TraceScope scope("lock", name, {});
+#else
+    static_cast<void>(name);
+#endif
+    mutex.lock();
+}
+
+// Writes the events of every thread that recorded any as Chrome trace
+// JSON and returns how many were written; call it while the traced
+// threads are idle. Writes an empty trace when tracing is compiled out.
+size_t writeChromeTrace(std::ostream& out);
+
+#endif // TRACE_H
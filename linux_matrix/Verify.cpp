@@ -0,0 +1,266 @@
+#include "Verify.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include "RandomFill.h"
+
+namespace {
+
+// Row bands per worker, so one slow band does not hold up the pool.
+constexpr size_t bandsPerWorker = 4;
+
+// Floating point values within this many ULPs always compare equal.
+constexpr uint64_t maxUlps = 4;
+
+// Runs function(band, first, last) over row bands [first, last) of rows on
+// the pool and returns the band count.
+template <typename Function>
+size_t forEachRowBand(ThreadPool& pool, size_t rows, Function function) {
+    const size_t bands = std::max<size_t>(1, std::min(rows, pool.size() * bandsPerWorker));
+    for (size_t band = 0; band < bands; ++band) {
+        const size_t first = rows * band / bands;
+        const size_t last = rows * (band + 1) / bands;
+        pool.submit([&function, band, first, last] { function(band, first, last); });
+    }
+    pool.wait();
+    return bands;
+}
+
+// Lowers first to row unless it already is smaller.
+void recordFirstRow(std::atomic<size_t>& first, size_t row) {
+    size_t current = first.load(std::memory_order_relaxed);
+    while (row < current && !first.compare_exchange_weak(current, row, std::memory_order_relaxed)) {
+    }
+}
+
+// Distance in units in the last place; values of opposite sign are
+// measured through zero.
+template <typename T>
+uint64_t ulpDistance(T a, T b) {
+    using Bits = typename std::conditional<sizeof(T) == 4, int32_t, int64_t>::type;
+    Bits bitsA;
+    Bits bitsB;
+    std::memcpy(&bitsA, &a, sizeof(T));
+    std::memcpy(&bitsB, &b, sizeof(T));
+    // Map sign-magnitude onto a monotonic two's complement scale.
+    if (bitsA < 0) {
+        bitsA = std::numeric_limits<Bits>::min() - bitsA;
+    }
+    if (bitsB < 0) {
+        bitsB = std::numeric_limits<Bits>::min() - bitsB;
+    }
+    return bitsA > bitsB ? static_cast<uint64_t>(bitsA) - static_cast<uint64_t>(bitsB)
+                         : static_cast<uint64_t>(bitsB) - static_cast<uint64_t>(bitsA);
+}
+
+// Index of the first failing element of a row, or npos. The first pass
+// has no early exit or data-dependent branch so that it vectorizes; only a
+// row that fails it is scanned element by element.
+template <typename Acc>
+size_t firstMismatchInRow(const Acc* expected, const Acc* actual, size_t cols, double tolerance) {
+    if constexpr (std::is_integral<Acc>::value) {
+        if (std::memcmp(expected, actual, cols * sizeof(Acc)) == 0) {
+            return Mismatch::npos;
+        }
+        return std::mismatch(expected, expected + cols, actual).first - expected;
+    } else {
+        const Acc limit = static_cast<Acc>(tolerance);
+        size_t outside = 0;
+        for (size_t j = 0; j < cols; ++j) {
+            // Written as !(x <= y) so that NaN counts as outside.
+            outside += !(std::fabs(actual[j] - expected[j]) <= limit * std::fabs(expected[j]));
+        }
+        if (outside == 0) {
+            return Mismatch::npos;
+        }
+        for (size_t j = 0; j < cols; ++j) {
+            const Acc want = expected[j];
+            const Acc got = actual[j];
+            if (want == got) {
+                continue;
+            }
+            if (std::isnan(got) || (ulpDistance(want, got) > maxUlps &&
+                                    !(std::fabs(got - want) <= limit * std::fabs(want)))) {
+                return j;
+            }
+        }
+        return Mismatch::npos;
+    }
+}
+
+template <typename T>
+double absolute(T value) {
+    return std::fabs(static_cast<double>(value));
+}
+
+} // namespace
+
+std::string Mismatch::describe() const {
+    std::ostringstream ss;
+    ss.precision(17);
+    ss << "row=" << row;
+    if (col != npos) {
+        ss << " col=" << col;
+    }
+    ss << " expected=" << expected << " actual=" << actual;
+    return ss.str();
+}
+
+template <typename Acc>
+double relativeTolerance(int size, double factor) {
+    if (std::is_integral<Acc>::value) {
+        return 0.0;
+    }
+    return factor * size * std::numeric_limits<Acc>::epsilon();
+}
+
+template <typename Acc>
+Mismatch compareMatrices(ThreadPool& pool, const Matrix<Acc>& expected, const Matrix<Acc>& actual, double tolerance) {
+    const size_t rows = expected.rows();
+    const size_t cols = expected.cols();
+    // Bands past the first failing row stop early; the result is still the
+    // first mismatch because every row before it is checked in full.
+    std::atomic<size_t> firstBadRow{ rows };
+    std::vector<Mismatch> found(std::max<size_t>(1, std::min(rows, pool.size() * bandsPerWorker)));
+    const size_t bands = forEachRowBand(pool, rows, [&](size_t band, size_t first, size_t last) {
+        for (size_t i = first; i < last && i < firstBadRow.load(std::memory_order_relaxed); ++i) {
+            const size_t j = firstMismatchInRow(expected.row(i), actual.row(i), cols, tolerance);
+            if (j != Mismatch::npos) {
+                found[band].found = true;
+                found[band].row = i;
+                found[band].col = j;
+                found[band].expected = static_cast<double>(expected(i, j));
+                found[band].actual = static_cast<double>(actual(i, j));
+                recordFirstRow(firstBadRow, i);
+                return;
+            }
+        }
+    });
+    for (size_t band = 0; band < bands; ++band) {
+        if (found[band].found) {
+            return found[band];
+        }
+    }
+    return Mismatch();
+}
+
+template <typename T, typename Acc>
+FreivaldsVerifier<T, Acc>::FreivaldsVerifier(ThreadPool& pool, const Matrix<T>& matrixA, const Matrix<T>& matrixB,
+                                             uint64_t seed, int trials)
+    : _size(matrixA.rows()), _trials(trials) {
+    const size_t n = _size;
+    for (int trial = 0; trial < trials; ++trial) {
+        std::vector<unsigned char> vector(n);
+        for (size_t j = 0; j < n; ++j) {
+            vector[j] = philoxValue(seed, firstStream + trial, j) & 1;
+        }
+
+        std::vector<Wide> productB(n);      // B * r
+        std::vector<double> magnitudeB;     // |B| * r
+        if (!std::is_integral<Acc>::value) {
+            magnitudeB.resize(n);
+        }
+        forEachRowBand(pool, n, [&](size_t, size_t first, size_t last) {
+            for (size_t k = first; k < last; ++k) {
+                const T* row = matrixB.row(k);
+                Wide sum = Wide();
+                double magnitude = 0.0;
+                for (size_t j = 0; j < n; ++j) {
+                    if (vector[j]) {
+                        sum += static_cast<Wide>(row[j]);
+                        magnitude += absolute(row[j]);
+                    }
+                }
+                productB[k] = sum;
+                if (!magnitudeB.empty()) {
+                    magnitudeB[k] = magnitude;
+                }
+            }
+        });
+
+        std::vector<Wide> expected(n);      // A * (B * r)
+        std::vector<double> magnitudes;     // |A| * (|B| * r)
+        if (!std::is_integral<Acc>::value) {
+            magnitudes.resize(n);
+        }
+        forEachRowBand(pool, n, [&](size_t, size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i) {
+                const T* row = matrixA.row(i);
+                Wide sum = Wide();
+                double magnitude = 0.0;
+                for (size_t k = 0; k < n; ++k) {
+                    sum += static_cast<Wide>(row[k]) * productB[k];
+                    if (!magnitudes.empty()) {
+                        magnitude += absolute(row[k]) * magnitudeB[k];
+                    }
+                }
+                expected[i] = sum;
+                if (!magnitudes.empty()) {
+                    magnitudes[i] = magnitude;
+                }
+            }
+        });
+
+        _vectors.push_back(std::move(vector));
+        _expected.push_back(std::move(expected));
+        _magnitudes.push_back(std::move(magnitudes));
+    }
+}
+
+template <typename T, typename Acc>
+Mismatch FreivaldsVerifier<T, Acc>::check(ThreadPool& pool, const Matrix<Acc>& resultMatrix, double tolerance) const {
+    const size_t n = _size;
+    // C * r is summed in double, which adds rounding of its own.
+    const double limit = tolerance + 2.0 * std::numeric_limits<Acc>::epsilon();
+    for (int trial = 0; trial < _trials; ++trial) {
+        const std::vector<unsigned char>& vector = _vectors[trial];
+        const std::vector<Wide>& expected = _expected[trial];
+        const std::vector<double>& magnitudes = _magnitudes[trial];
+
+        std::atomic<size_t> firstBadRow{ n };
+        std::vector<Mismatch> found(std::max<size_t>(1, std::min(n, pool.size() * bandsPerWorker)));
+        const size_t bands = forEachRowBand(pool, n, [&](size_t band, size_t first, size_t last) {
+            for (size_t i = first; i < last && i < firstBadRow.load(std::memory_order_relaxed); ++i) {
+                const Acc* row = resultMatrix.row(i);
+                Wide sum = Wide();
+                for (size_t j = 0; j < n; ++j) {
+                    sum += vector[j] ? static_cast<Wide>(row[j]) : Wide();
+                }
+                bool failed;
+                if constexpr (std::is_integral<Acc>::value) {
+                    failed = sum != expected[i];
+                } else {
+                    failed = !(std::fabs(sum - expected[i]) <= limit * magnitudes[i]);
+                }
+                if (failed) {
+                    found[band].found = true;
+                    found[band].row = i;
+                    found[band].expected = static_cast<double>(static_cast<Acc>(expected[i]));
+                    found[band].actual = static_cast<double>(static_cast<Acc>(sum));
+                    recordFirstRow(firstBadRow, i);
+                    return;
+                }
+            }
+        });
+        for (size_t band = 0; band < bands; ++band) {
+            if (found[band].found) {
+                return found[band];
+            }
+        }
+    }
+    return Mismatch();
+}
+
+#define INSTANTIATE_VERIFY(T, Acc) \
+    template double relativeTolerance<Acc>(int, double); \
+    template Mismatch compareMatrices<Acc>(ThreadPool&, const Matrix<Acc>&, const Matrix<Acc>&, double); \
+    template class FreivaldsVerifier<T, Acc>;
+
+INSTANTIATE_VERIFY(int, int)
+INSTANTIATE_VERIFY(int, int64_t)
+INSTANTIATE_VERIFY(float, float)
+INSTANTIATE_VERIFY(double, double)
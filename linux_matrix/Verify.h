@@ -0,0 +1,84 @@
+#ifndef VERIFY_H
+#define VERIFY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "Matrix.h"
+#include "ThreadPool.h"
+
+// First element (in row-major order) that failed a check. Freivalds only
+// knows the row, so col is npos there and the values are those of C * r.
+struct Mismatch {
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    bool found = false;
+    size_t row = 0;
+    size_t col = npos;
+    double expected = 0.0;
+    double actual = 0.0;
+
+    // "row=3 col=17 expected=... actual=..."
+    std::string describe() const;
+};
+
+// Allowed relative error of a floating point result: a size-term dot
+// product in another summation order (or with FMA) is within about
+// size * epsilon of the reference. Callers scale it for algorithms with a
+// weaker bound. Integer results must match exactly (0).
+template <typename Acc>
+double relativeTolerance(int size, double factor = 1.0);
+
+// Compares row bands of expected and actual on the pool. Integers compare
+// exactly; floating point values pass when they are within a few ULPs or
+// within tolerance (relative to the expected value). NaN never passes.
+template <typename Acc>
+Mismatch compareMatrices(ThreadPool& pool, const Matrix<Acc>& expected, const Matrix<Acc>& actual, double tolerance);
+
+// Type the Freivalds sums run in: integer sums wrap in the unsigned type
+// like the kernels, floating point sums use double.
+template <typename Acc, bool = std::is_integral<Acc>::value>
+struct FreivaldsSum {
+    using type = double;
+};
+
+template <typename Acc>
+struct FreivaldsSum<Acc, true> {
+    using type = typename std::make_unsigned<Acc>::type;
+};
+
+// Freivalds' check of C == A * B: for random 0/1 vectors r it compares
+// C * r with A * (B * r), O(n^2) per trial instead of the O(n^3) of a
+// reference product. A wrong C passes one trial with probability at most
+// 1/2, also for the wrapping int arithmetic. A * (B * r) is computed once
+// by the constructor, so checking many results of the same inputs is cheap.
+// r of trial t is drawn from stream firstStream + t of seed.
+template <typename T, typename Acc>
+class FreivaldsVerifier {
+public:
+    static constexpr uint64_t firstStream = 1 << 16;
+
+    FreivaldsVerifier(ThreadPool& pool, const Matrix<T>& matrixA, const Matrix<T>& matrixB,
+                      uint64_t seed, int trials);
+
+    // Floating point rows pass when |C r - A B r| is within tolerance of
+    // |A| |B| r plus the rounding of the check itself, so a single element
+    // off by less than about tolerance times its row sum goes unnoticed;
+    // use compareMatrices when that matters.
+    Mismatch check(ThreadPool& pool, const Matrix<Acc>& resultMatrix, double tolerance) const;
+
+    int trials() const { return _trials; }
+
+private:
+    using Wide = typename FreivaldsSum<Acc>::type;
+
+    size_t _size;
+    int _trials;
+    std::vector<std::vector<unsigned char>> _vectors;   // r per trial
+    std::vector<std::vector<Wide>> _expected;           // A * (B * r) per trial
+    std::vector<std::vector<double>> _magnitudes;       // |A| * (|B| * r), floating point only
+};
+
+#endif // VERIFY_H
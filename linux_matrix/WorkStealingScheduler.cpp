@@ -0,0 +1,283 @@
+#include "WorkStealingScheduler.h"
+
+#include <sched.h>
+#include <chrono>
+#include <stdexcept>
+#include "ThreadPool.h"
+#include "Topology.h"
+#include "Trace.h"
+
+namespace {
+thread_local int currentWorkerIndex = -1;
+thread_local const void* currentScheduler = nullptr;
+
+// Probes of the other deques before a worker gives up and sleeps.
+constexpr int idleSpinRounds = 64;
+}
+
+template <typename T>
+ChaseLevDeque<T>::ChaseLevDeque(int64_t capacity) {
+    int64_t size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    _arrays.emplace_back(new Array(size));
+    _array.store(_arrays.back().get(), std::memory_order_relaxed);
+}
+
+template <typename T>
+typename ChaseLevDeque<T>::Array* ChaseLevDeque<T>::grow(Array* old, int64_t top, int64_t bottom) {
+    _arrays.emplace_back(new Array(old->size * 2));
+    Array* bigger = _arrays.back().get();
+    for (int64_t i = top; i < bottom; ++i) {
+        bigger->put(i, old->get(i));
+    }
+    _array.store(bigger, std::memory_order_release);
+    return bigger;
+}
+
+template <typename T>
+void ChaseLevDeque<T>::push(T* item) {
+    int64_t bottom = _bottom.load(std::memory_order_relaxed);
+    int64_t top = _top.load(std::memory_order_acquire);
+    Array* array = _array.load(std::memory_order_relaxed);
+    if (bottom - top > array->size - 1) {
+        array = grow(array, top, bottom);
+    }
+    array->put(bottom, item);
+    _bottom.store(bottom + 1, std::memory_order_release);
+}
+
+template <typename T>
+T* ChaseLevDeque<T>::take() {
+    int64_t bottom = _bottom.load(std::memory_order_relaxed) - 1;
+    Array* array = _array.load(std::memory_order_relaxed);
+    // seq_cst store/load pair instead of the paper's fence: the owner and
+    // a thief must agree on who gets the last element.
+    _bottom.store(bottom, std::memory_order_seq_cst);
+    int64_t top = _top.load(std::memory_order_seq_cst);
+
+    if (top > bottom) {
+        _bottom.store(bottom + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    T* item = array->get(bottom);
+    if (top == bottom) {
+        if (!_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            item = nullptr;
+        }
+        _bottom.store(bottom + 1, std::memory_order_relaxed);
+    }
+    return item;
+}
+
+template <typename T>
+T* ChaseLevDeque<T>::steal() {
+    int64_t top = _top.load(std::memory_order_seq_cst);
+    int64_t bottom = _bottom.load(std::memory_order_seq_cst);
+    if (top >= bottom) {
+        return nullptr;
+    }
+    Array* array = _array.load(std::memory_order_acquire);
+    T* item = array->get(top);
+    if (!_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        return nullptr;
+    }
+    return item;
+}
+
+template class ChaseLevDeque<WorkStealingScheduler::Task>;
+
+WorkStealingScheduler::WorkStealingScheduler(unsigned threadCount, std::vector<int> cpus) : _cpus(std::move(cpus)) {
+    if (threadCount == 0) {
+        threadCount = ThreadPool::hardwareConcurrency();
+    }
+    for (unsigned i = 0; i < threadCount; ++i) {
+        _workers.emplace_back(new Worker);
+        _workers.back()->randomState = 0x9E3779B97F4A7C15ull * (i + 1);
+    }
+    for (size_t i = 0; i < _workers.size(); ++i) {
+        if (pthread_create(&_workers[i]->thread, nullptr, workerMain, this) != 0) {
+            _stopping = true;
+            _workAvailable.notify_all();
+            for (size_t j = 0; j < i; ++j) {
+                pthread_join(_workers[j]->thread, nullptr);
+            }
+            throw std::runtime_error("WorkStealingScheduler: pthread_create failed");
+        }
+    }
+    std::unique_lock<std::mutex> lock(_mutex);
+    _allDone.wait(lock, [this] { return _started == _workers.size(); });
+}
+
+WorkStealingScheduler::~WorkStealingScheduler() {
+    wait();
+    _stopping = true;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+    }
+    _workAvailable.notify_all();
+    for (auto& worker : _workers) {
+        pthread_join(worker->thread, nullptr);
+    }
+}
+
+void WorkStealingScheduler::submit(std::function<void()> task) {
+    Task* item = new Task{ std::move(task) };
+    _pending.fetch_add(1, std::memory_order_relaxed);
+    if (currentScheduler == this) {
+        _workers[currentWorkerIndex]->deque.push(item);
+    } else {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _injected.push_back(item);
+        _injectedCount.fetch_add(1, std::memory_order_release);
+    }
+    if (_idle.load(std::memory_order_relaxed) > 0) {
+        _workAvailable.notify_one();
+    }
+}
+
+void WorkStealingScheduler::wait() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _allDone.wait(lock, [this] { return _pending.load(std::memory_order_acquire) == 0; });
+}
+
+bool WorkStealingScheduler::hasIdleWorkers() const {
+    return _idle.load(std::memory_order_relaxed) > 0;
+}
+
+unsigned WorkStealingScheduler::size() const {
+    return static_cast<unsigned>(_workers.size());
+}
+
+unsigned WorkStealingScheduler::pinnedWorkers() const {
+    return _pinned.load(std::memory_order_relaxed);
+}
+
+WorkStealingScheduler::Stats WorkStealingScheduler::stats() const {
+    Stats total;
+    for (const auto& worker : _workers) {
+        total.tasksExecuted += worker->tasksExecuted.load(std::memory_order_relaxed);
+        total.steals += worker->steals.load(std::memory_order_relaxed);
+        total.failedSteals += worker->failedSteals.load(std::memory_order_relaxed);
+        total.idleWaits += worker->idleWaits.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+void WorkStealingScheduler::resetStats() {
+    for (auto& worker : _workers) {
+        worker->tasksExecuted = 0;
+        worker->steals = 0;
+        worker->failedSteals = 0;
+        worker->idleWaits = 0;
+    }
+}
+
+std::vector<pid_t> WorkStealingScheduler::threadIds() const {
+    std::vector<pid_t> ids;
+    for (const auto& worker : _workers) {
+        ids.push_back(worker->threadId);
+    }
+    return ids;
+}
+
+int WorkStealingScheduler::workerIndex() {
+    return currentWorkerIndex;
+}
+
+void* WorkStealingScheduler::workerMain(void* param) {
+    WorkStealingScheduler* scheduler = static_cast<WorkStealingScheduler*>(param);
+    scheduler->workerLoop(scheduler->_nextIndex.fetch_add(1));
+    return nullptr;
+}
+
+WorkStealingScheduler::Task* WorkStealingScheduler::findTask(Worker& self, int index) {
+    if (Task* task = self.deque.take()) {
+        return task;
+    }
+    if (_injectedCount.load(std::memory_order_acquire) > 0) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_injected.empty()) {
+            Task* task = _injected.front();
+            _injected.pop_front();
+            _injectedCount.fetch_sub(1, std::memory_order_relaxed);
+            return task;
+        }
+    }
+    const size_t count = _workers.size();
+    if (count < 2) {
+        return nullptr;
+    }
+    // xorshift64 picks the first victim; the rest are probed in order.
+    self.randomState ^= self.randomState << 13;
+    self.randomState ^= self.randomState >> 7;
+    self.randomState ^= self.randomState << 17;
+    size_t start = self.randomState % count;
+    for (size_t i = 0; i < count; ++i) {
+        size_t victim = (start + i) % count;
+        if (victim == static_cast<size_t>(index)) {
+            continue;
+        }
+        if (Task* task = _workers[victim]->deque.steal()) {
+            self.steals.fetch_add(1, std::memory_order_relaxed);
+            return task;
+        }
+    }
+    self.failedSteals.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+}
+
+void WorkStealingScheduler::runTask(Worker& self, Task* task) {
+    task->function();
+    delete task;
+    self.tasksExecuted.fetch_add(1, std::memory_order_relaxed);
+    if (_pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _allDone.notify_all();
+    }
+}
+
+void WorkStealingScheduler::workerLoop(int index) {
+    currentWorkerIndex = index;
+    currentScheduler = this;
+    Worker& self = *_workers[index];
+    self.threadId = currentThreadId();
+    if (!_cpus.empty() && pinCurrentThread(_cpus[index % _cpus.size()])) {
+        _pinned.fetch_add(1, std::memory_order_relaxed);
+    }
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        ++_started;
+    }
+    _allDone.notify_all();
+    TRACE_THREAD_NAME("steal worker " + std::to_string(index));
+
+    while (!_stopping.load(std::memory_order_acquire)) {
+        if (Task* task = findTask(self, index)) {
+            runTask(self, task);
+            continue;
+        }
+
+        _idle.fetch_add(1, std::memory_order_relaxed);
+        Task* task = nullptr;
+        for (int round = 0; round < idleSpinRounds && !task; ++round) {
+            sched_yield();
+            task = findTask(self, index);
+        }
+        if (!task) {
+            // Deque pushes do not take _mutex, so a notify can be missed;
+            // the timeout bounds how long such a task waits for a thief.
+            TRACE_SCOPE("steal", "idle wait");
+            std::unique_lock<std::mutex> lock(_mutex);
+            self.idleWaits.fetch_add(1, std::memory_order_relaxed);
+            _workAvailable.wait_for(lock, std::chrono::microseconds(200), [this] {
+                return _stopping.load(std::memory_order_relaxed) || !_injected.empty();
+            });
+        }
+        _idle.fetch_sub(1, std::memory_order_relaxed);
+        if (task) {
+            runTask(self, task);
+        }
+    }
+}
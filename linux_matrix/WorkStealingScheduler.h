@@ -0,0 +1,130 @@
+#ifndef WORK_STEALING_SCHEDULER
+#define WORK_STEALING_SCHEDULER
+
+#include <pthread.h>
+#include <sys/types.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Chase-Lev work-stealing deque ("Dynamic Circular Work-Stealing Deque",
+// SPAA 2005, with the C11 orderings of Le et al., PPoPP 2013). Only the
+// owning worker calls push/take, at the bottom; any thread may steal from
+// the top. Grown arrays are retired, not freed, until the deque dies, so a
+// concurrent thief never reads freed memory.
+template <typename T>
+class ChaseLevDeque {
+public:
+    explicit ChaseLevDeque(int64_t capacity = 256);
+
+    ChaseLevDeque(const ChaseLevDeque&) = delete;
+    ChaseLevDeque& operator=(const ChaseLevDeque&) = delete;
+
+    void push(T* item);
+    T* take();          // nullptr when empty
+    T* steal();         // nullptr when empty or another thread won the race
+
+private:
+    struct Array {
+        explicit Array(int64_t size) : size(size), slots(new std::atomic<T*>[size]) {}
+        T* get(int64_t index) const { return slots[index & (size - 1)].load(std::memory_order_relaxed); }
+        void put(int64_t index, T* item) { slots[index & (size - 1)].store(item, std::memory_order_relaxed); }
+
+        int64_t size;
+        std::unique_ptr<std::atomic<T*>[]> slots;
+    };
+
+    Array* grow(Array* old, int64_t top, int64_t bottom);
+
+    alignas(64) std::atomic<int64_t> _top{ 0 };
+    alignas(64) std::atomic<int64_t> _bottom{ 0 };
+    std::atomic<Array*> _array;
+    std::vector<std::unique_ptr<Array>> _arrays;
+};
+
+// Pool of pthread workers that each own a ChaseLevDeque. Tasks spawned by a
+// worker go to its own deque (LIFO, cache-warm); idle workers steal the
+// oldest task of a random victim. Tasks submitted from outside the pool go
+// through a shared injection queue.
+class WorkStealingScheduler {
+public:
+    struct Stats {
+        uint64_t tasksExecuted = 0;
+        uint64_t steals = 0;         // successful steals
+        uint64_t failedSteals = 0;   // probes that found nothing to steal
+        uint64_t idleWaits = 0;      // times a worker went to sleep for lack of work
+    };
+
+    // threadCount == 0 means one worker per online CPU; cpus pins workers
+    // as in ThreadPool.
+    explicit WorkStealingScheduler(unsigned threadCount = 0, std::vector<int> cpus = {});
+    ~WorkStealingScheduler();
+
+    WorkStealingScheduler(const WorkStealingScheduler&) = delete;
+    WorkStealingScheduler& operator=(const WorkStealingScheduler&) = delete;
+
+    // Adds a task. From a worker of this scheduler the task is pushed on the
+    // caller's own deque, otherwise on the injection queue.
+    void submit(std::function<void()> task);
+
+    // Blocks until every submitted task, including tasks they spawned, ran.
+    // Must not be called from inside a task.
+    void wait();
+
+    // True while at least one worker is looking for work; a running task
+    // uses this to decide whether splitting itself would pay off.
+    bool hasIdleWorkers() const;
+
+    unsigned size() const;
+    unsigned pinnedWorkers() const;
+    Stats stats() const;
+    void resetStats();
+
+    // Kernel thread id of every worker, by worker index.
+    std::vector<pid_t> threadIds() const;
+
+    // Index of the scheduler worker running the caller, or -1.
+    static int workerIndex();
+
+private:
+    struct Task {
+        std::function<void()> function;
+    };
+
+    struct Worker {
+        ChaseLevDeque<Task> deque;
+        pthread_t thread;
+        pid_t threadId = 0;          // set before the constructor returns
+        uint64_t randomState = 0;
+        alignas(64) std::atomic<uint64_t> tasksExecuted{ 0 };
+        std::atomic<uint64_t> steals{ 0 };
+        std::atomic<uint64_t> failedSteals{ 0 };
+        std::atomic<uint64_t> idleWaits{ 0 };
+    };
+
+    static void* workerMain(void* param);
+    void workerLoop(int index);
+    Task* findTask(Worker& self, int index);
+    void runTask(Worker& self, Task* task);
+
+    std::vector<std::unique_ptr<Worker>> _workers;
+    std::mutex _mutex;                       // guards _injected, _started and sleeping
+    std::condition_variable _workAvailable;
+    std::condition_variable _allDone;
+    std::deque<Task*> _injected;
+    std::vector<int> _cpus;
+    unsigned _started = 0;                   // guarded by _mutex
+    std::atomic<unsigned> _pinned{ 0 };
+    std::atomic<size_t> _injectedCount{ 0 };
+    std::atomic<int64_t> _pending{ 0 };
+    std::atomic<int> _idle{ 0 };
+    std::atomic<bool> _stopping{ false };
+    std::atomic<int> _nextIndex{ 0 };
+};
+
+#endif // WORK_STEALING_SCHEDULER
@@ -4,159 +4,1002 @@
 #include <algorithm>
 #include <random>
 #include <pthread.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <mutex>
 #include <fstream>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+#include "AsyncReader.h"
+#include "AutoTuner.h"
+#include "BenchOptions.h"
+#include "BlockedMultiply.h"
+#include "ElementType.h"
+#include "Gemm.h"
+#include "GemmKernel.h"
+#include "GotoGemm.h"
+#include "Matrix.h"
+#include "MatrixCache.h"
+#include "OutOfCore.h"
+#include "PerfCounters.h"
+#include "RandomFill.h"
+#include "Report.h"
+#include "Strassen.h"
+#include "ThreadPool.h"
+#include "TiledMatrixFile.h"
+#include "Trace.h"
+#include "Topology.h"
+#include "Verify.h"
+#include "WorkStealingScheduler.h"
 
-std::mutex resultMutex;
+// Zeroes row band w of the matrix on pool worker w. A page is placed on the
+// NUMA node of the thread that first writes it, so each band ends up next
+// to the pinned worker it was given to.
+template <typename T>
+void firstTouch(ThreadPool& pool, Matrix<T>& matrix) {
+    const size_t workers = pool.size();
+    pool.runOnEachWorker([&](int worker) {
+        matrix.zeroRows(matrix.rows() * worker / workers, matrix.rows() * (worker + 1) / workers);
+    });
+}
+
+template <typename T, typename Acc>
+long long multiplyGotoBlocked(const GemmKernel<T, Acc>& kernel, const CacheBlocking& blocking, ThreadPool& pool,
+                           const Matrix<T>& matrixA,
+                           const Matrix<T>& matrixB,
+                           Matrix<Acc>& resultMatrix) {
+    resultMatrix.fill(Acc());
+    auto startTime = std::chrono::steady_clock::now();
+    multiplyGoto(kernel, blocking, pool, matrixA.view(), matrixB.view(), resultMatrix.view());
+    auto endTime = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+}
+
+// Strassen stores C in the operand type. A wider resultMatrix is filled
+// from product, and the widening is timed with the multiplication.
+template <typename T, typename Acc>
+long long multiplyStrassenTimed(StrassenMultiplier<T>& strassen, ThreadPool& pool,
+                                const Matrix<T>& matrixA,
+                                const Matrix<T>& matrixB,
+                                Matrix<T>& product,
+                                Matrix<Acc>& resultMatrix) {
+    auto startTime = std::chrono::steady_clock::now();
+    if constexpr (std::is_same<T, Acc>::value) {
+        strassen.multiply(pool, matrixA, matrixB, resultMatrix);
+    } else {
+        strassen.multiply(pool, matrixA, matrixB, product);
+        for (size_t i = 0; i < product.rows(); ++i) {
+            std::copy(product.row(i), product.row(i) + product.cols(), resultMatrix.row(i));
+        }
+    }
+    auto endTime = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+}
+
+// The kernel Strassen uses for kernel: itself, or the one of the same ISA
+// that accumulates in the operand type.
+template <typename T>
+const GemmKernel<T>& operandTypeKernel(const GemmKernel<T>& kernel) {
+    return kernel;
+}
+
+template <typename T, typename Acc>
+const GemmKernel<T>& operandTypeKernel(const GemmKernel<T, Acc>& kernel) {
+    return selectGemmKernel<T>(kernel.name);
+}
 
-struct BlockArgs {
-    const std::vector<std::vector<int>>* matrixA;
-    const std::vector<std::vector<int>>* matrixB;
-    std::vector<std::vector<int>>* resultMatrix;
-    int blockRowA, blockColA, blockRowB, blockColB, blockSize;
+// Blocking derived for kernel, with --mc/--kc/--nc applied.
+template <typename T, typename Acc>
+CacheBlocking configuredBlocking(const BenchOptions& options, const GemmKernel<T, Acc>& kernel) {
+    CacheBlocking blocking = deriveCacheBlocking(kernel);
+    blocking.mc = options.mc > 0 ? options.mc : blocking.mc;
+    blocking.kc = options.kc > 0 ? options.kc : blocking.kc;
+    blocking.nc = options.nc > 0 ? options.nc : blocking.nc;
+    return blocking;
+}
+
+// Removes the files when it goes out of scope, also on errors.
+struct ScratchFiles {
+    std::vector<std::string> paths;
+
+    ~ScratchFiles() {
+        for (const std::string& path : paths) {
+            std::remove(path.c_str());
+        }
+    }
 };
 
-void fillRandom(std::vector<std::vector<int>>& matrix, int minValue = 1, int maxValue = 10) {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> dist(minValue, maxValue);
-    for (auto& row : matrix) {
-        for (auto& element : row) {
-            element = dist(gen);
+// Runs one configuration options.warmup + options.repetitions times and
+// checks the result of the last run with check(tolerance). perf, when
+// given, counts the timed runs only.
+template <typename Multiply, typename Check>
+std::vector<long long> measure(const BenchOptions& options, Multiply multiply,
+                               Check check, double tolerance, Mismatch& mismatch, PerfMonitor* perf) {
+    for (int i = 0; i < options.warmup; ++i) {
+        multiply();
+    }
+    std::vector<long long> samples;
+    if (perf) {
+        perf->start();
+    }
+    for (int i = 0; i < options.repetitions; ++i) {
+        TRACE_SCOPE("bench", "run", i);
+        samples.push_back(multiply());
+    }
+    if (perf) {
+        perf->stop();
+    }
+    mismatch = check(tolerance);
+    return samples;
+}
+
+BenchRecord makeRecord(int size, unsigned threads, const char* dtype, const std::string& algorithm, const char* isa,
+                       int blockSize, const std::string& details, const std::vector<long long>& samples,
+                       const Mismatch& mismatch) {
+    BenchRecord record;
+    record.size = size;
+    record.threads = threads;
+    record.dtype = dtype;
+    record.algorithm = algorithm;
+    record.isa = isa;
+    record.blockSize = blockSize;
+    record.details = details;
+    if (mismatch.found) {
+        record.details += (record.details.empty() ? "" : " ") + std::string("mismatch: ") + mismatch.describe();
+    }
+    record.samplesNs = samples;
+    TimingStats stats = summarizeTimings(samples);
+    record.medianNs = stats.medianNs;
+    record.minNs = stats.minNs;
+    record.p95Ns = stats.p95Ns;
+    record.gops = gigaOpsPerSecond(size, size, size, stats.medianNs);
+    record.correct = !mismatch.found;
+    return record;
+}
+
+void printRecord(const BenchRecord& record, double mutexMedianNs) {
+    if (record.shape.empty()) {
+        std::cout << "size=" << record.size;
+    } else {
+        std::cout << "shape=" << record.shape;
+    }
+    std::cout << " threads=" << record.threads;
+    if (record.backend != "pool") {
+        std::cout << " backend=" << record.backend;
+    }
+    std::cout << " dtype=" << record.dtype
+              << " algo=" << record.algorithm
+              << " isa=" << record.isa;
+    if (record.blockSize > 0) {
+        std::cout << " k=" << record.blockSize;
+    }
+    if (!record.details.empty()) {
+        std::cout << " " << record.details;
+    }
+    std::cout << " reps=" << record.samplesNs.size()
+              << " median_ms=" << record.medianNs / 1e6
+              << " min_ms=" << record.minNs / 1e6
+              << " p95_ms=" << record.p95Ns / 1e6
+              << " gops=" << record.gops;
+    if (mutexMedianNs > 0.0 && record.medianNs > 0.0) {
+        std::cout << " speedup_vs_mutex=" << mutexMedianNs / record.medianNs;
+    }
+    std::cout << " correct=" << (record.correct ? "YES" : "NO") << "\n";
+}
+
+// Counts the caller and every worker of pool that may run a product, or
+// nullptr when --perf is off.
+std::unique_ptr<PerfMonitor> monitorPool(const BenchOptions& options, ThreadPool& pool) {
+    std::unique_ptr<PerfMonitor> perf;
+    if (options.perf != "off") {
+        perf.reset(new PerfMonitor);
+        perf->addThread("main", currentThreadId());
+        std::vector<pid_t> workerIds(pool.size());
+        pool.runOnEachWorker([&](int index) { workerIds[index] = currentThreadId(); });
+        for (size_t i = 0; i < workerIds.size(); ++i) {
+            perf->addThread("pool" + std::to_string(i), workerIds[i]);
         }
     }
+    return perf;
+}
+
+// --perf=threads: the counts of each thread per run.
+void printThreadCounts(const PerfMonitor& perf, size_t runs, double flops) {
+    for (size_t thread = 0; thread < perf.threadCount(); ++thread) {
+        PerfCounts counts = perf.read(thread);
+        // Threads that never ran a task, e.g. the scheduler's during pool
+        // algorithms, would only add noise.
+        if (counts[PerfEvent::Instructions] > 0) {
+            std::cout << "  " << perf.label(thread) << ": " << counts.dividedBy(runs).describe(flops) << "\n";
+        }
+    }
+}
+
+// Whether sums of inner products of the benchmark's values (1 to 100) fit
+// in an int.
+bool int32SumsFit(long long inner) {
+    const long long maxProduct = 100LL * 100;
+    return inner * maxProduct <= std::numeric_limits<int>::max();
+}
+
+// --dtype=int32 accumulates in int, which wraps once the sums no longer
+// fit; the reference wraps alike, so the correctness check cannot tell.
+void warnInt32Overflow(const BenchOptions& options) {
+    if (std::find(options.elementTypes.begin(), options.elementTypes.end(), ElementType::Int32) ==
+        options.elementTypes.end()) {
+        return;
+    }
+    long long inner = 0;
+    for (int size : options.sizes) {
+        inner = std::max<long long>(inner, size);
+    }
+    for (const GemmShape& shape : options.gemmShapes) {
+        inner = std::max<long long>(inner, shape.k);
+    }
+    for (const BatchShape& batch : options.batches) {
+        inner = std::max<long long>(inner, batch.size);
+    }
+    if (!int32SumsFit(inner)) {
+        std::cerr << "warning: --dtype=int32 sums of an inner dimension of " << inner << " can exceed INT_MAX"
+                  << " and wrap; --dtype=int64 accumulates in int64\n";
+    }
 }
 
-long long multiplyNaive(const std::vector<std::vector<int>>& matrixA,
-                        const std::vector<std::vector<int>>& matrixB,
-                        std::vector<std::vector<int>>& resultMatrix) {
-    int size = matrixA.size();
-    auto startTime = std::chrono::high_resolution_clock::now();
-    
-    for (int i = 0; i < size; ++i) {
-        for (int j = 0; j < size; ++j) {
-            int sum = 0;
-            for (int k = 0; k < size; ++k) {
-                sum += matrixA[i][k] * matrixB[k][j];
+// Settings shared by the runs of every element type.
+struct BenchEnvironment {
+    const BenchOptions& options;
+    const Topology& topology;
+    bool pinned;            // workers are pinned to CPUs
+    bool placeMemory;       // and matrices are first-touched by them
+    uint64_t seed;          // of the input matrices
+    std::vector<BenchRecord>& records;
+    TuningDatabase* tuning; // --tune-db, when the tuned algorithm runs
+
+    unsigned resolvedThreads(unsigned threadCount) const {
+        return threadCount > 0 ? threadCount : ThreadPool::hardwareConcurrency();
+    }
+
+    std::vector<int> cpusFor(unsigned threadCount) const {
+        return assignCpus(topology, options.placement, resolvedThreads(threadCount));
+    }
+
+    void checkPinned(const char* what, unsigned pinnedCount, unsigned workerCount) const {
+        if (pinned && pinnedCount < workerCount) {
+            std::cerr << "warning: " << what << ": only " << pinnedCount << " of " << workerCount
+                      << " workers could be pinned\n";
+        }
+    }
+};
+
+// Every configuration of options for one element type. Throws when the
+// requested ISA has no kernel for this type on this CPU.
+template <ElementType Type>
+void runBenchmarks(const BenchEnvironment& environment) {
+    using T = typename ElementTraits<Type>::Element;
+    using Acc = typename ElementTraits<Type>::Accumulator;
+    const BenchOptions& options = environment.options;
+    const char* dtype = elementTypeName(Type);
+
+    std::vector<const GemmKernel<T, Acc>*> kernels;
+    if (options.isa == "all") {
+        kernels = supportedGemmKernels<T, Acc>();
+    } else {
+        kernels.push_back(&selectGemmKernel<T, Acc>(options.isa));
+    }
+
+    // Fills, first-touches and checks the matrices; sized for the largest
+    // pool so that row bands land where the benchmark workers run.
+    unsigned maxThreads = 0;
+    for (unsigned threadCount : options.threads) {
+        maxThreads = std::max(maxThreads, environment.resolvedThreads(threadCount));
+    }
+    ThreadPool helper(maxThreads, environment.cpusFor(maxThreads));
+    const bool freivalds = options.verify == "freivalds";
+
+    for (int size : options.sizes) {
+        const double tolerance = relativeTolerance<Acc>(size);
+        auto allocateInput = [&] { return environment.placeMemory ? Matrix<T>::uninitialized(size, size) : Matrix<T>(size, size); };
+        auto allocateResult = [&] { return environment.placeMemory ? Matrix<Acc>::uninitialized(size, size) : Matrix<Acc>(size, size); };
+        // fillRandom and loadCachedMatrix write the same row bands as
+        // firstTouch, so they place the inputs themselves.
+        Matrix<T> matrixA = allocateInput();
+        Matrix<T> matrixB = allocateInput();
+        Matrix<Acc> parallelResult = allocateResult();
+        Matrix<Acc> referenceResult = freivalds ? Matrix<Acc>() : allocateResult();
+        if (environment.placeMemory) {
+            firstTouch(helper, parallelResult);
+            if (!freivalds) {
+                firstTouch(helper, referenceResult);
+            }
+        }
+
+        const MatrixCacheKey cacheKey = { Type, size, environment.seed };
+        // Loads role from the cache; false when caching is off or the file
+        // has to be (re)generated.
+        auto loadCached = [&](auto& matrix, const char* role) {
+            if (options.cacheDir.empty()) {
+                return false;
+            }
+            const std::string path = matrixCachePath(options.cacheDir, cacheKey, role);
+            std::string reason;
+            if (loadCachedMatrix(helper, path, cacheKey, matrix, reason)) {
+                return true;
+            }
+            std::cout << "Cache " << path << ": " << reason << ", regenerating\n";
+            return false;
+        };
+        auto storeCached = [&](const auto& matrix, const char* role) {
+            if (options.cacheDir.empty()) {
+                return;
+            }
+            try {
+                storeCachedMatrix(helper, matrixCachePath(options.cacheDir, cacheKey, role), cacheKey, matrix);
+            } catch (const std::exception& error) {
+                std::cerr << "warning: cache not written: " << error.what() << "\n";
+            }
+        };
+
+        if (!loadCached(matrixA, "a")) {
+            fillRandom<T>(helper, matrixA, environment.seed, 0, 1, 100);
+            storeCached(matrixA, "a");
+        }
+        if (!loadCached(matrixB, "b")) {
+            fillRandom<T>(helper, matrixB, environment.seed, 1, 1, 100);
+            storeCached(matrixB, "b");
+        }
+
+        std::unique_ptr<FreivaldsVerifier<T, Acc>> verifier;
+        if (freivalds) {
+            verifier.reset(new FreivaldsVerifier<T, Acc>(helper, matrixA, matrixB, environment.seed, options.trials));
+            std::cout << "Verify " << size << "x" << size << " " << dtype << " : freivalds trials="
+                      << verifier->trials() << "\n";
+        } else if (loadCached(referenceResult, "ref")) {
+            std::cout << "Naive " << size << "x" << size << " " << dtype << " : cached\n";
+        } else {
+            long long naiveTime = multiplyNaive(matrixA, matrixB, referenceResult);
+            std::cout << "Naive " << size << "x" << size << " " << dtype << " : " << naiveTime / 1e6 << " ms\n";
+            storeCached(referenceResult, "ref");
+        }
+        auto check = [&](double allowed) {
+            return freivalds ? verifier->check(helper, parallelResult, allowed)
+                             : compareMatrices(helper, referenceResult, parallelResult, allowed);
+        };
+
+        if (environment.tuning) {
+            // The tuned algorithm picks its own thread count, so it runs
+            // outside the --threads sweep on pools made for it.
+            std::map<unsigned, std::unique_ptr<ThreadPool>> pools;
+            auto poolFor = [&](unsigned threadCount) -> ThreadPool& {
+                std::unique_ptr<ThreadPool>& tunePool = pools[threadCount];
+                if (!tunePool) {
+                    tunePool.reset(new ThreadPool(threadCount, environment.cpusFor(threadCount)));
+                }
+                return *tunePool;
+            };
+            // Every micro-kernel is a candidate unless --isa names one.
+            std::vector<const GemmKernel<T, Acc>*> tuneKernels = kernels;
+            if (options.isa == "auto") {
+                tuneKernels = supportedGemmKernels<T, Acc>();
             }
-            resultMatrix[i][j] = sum;
-        }
-    }
-    
-    auto endTime = std::chrono::high_resolution_clock::now();
-    return std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count();
-}
-
-void* multiplyBlockWorker(void* param) {
-    BlockArgs* args = static_cast<BlockArgs*>(param);
-    int size = args->matrixA->size();
-    
-    int startRowA = args->blockRowA * args->blockSize;
-    int endRowA = std::min((args->blockRowA + 1) * args->blockSize, size);
-    int startColA = args->blockColA * args->blockSize;
-    int endColA = std::min((args->blockColA + 1) * args->blockSize, size);
-    
-    int startRowB = args->blockRowB * args->blockSize;
-    int endRowB = std::min((args->blockRowB + 1) * args->blockSize, size);
-    int startColB = args->blockColB * args->blockSize;
-    int endColB = std::min((args->blockColB + 1) * args->blockSize, size);
-
-    for (int i = startRowA; i < endRowA; ++i) {
-        for (int j = startColB; j < endColB; ++j) {
-            int sum = 0;
-            for (int t = 0; t < args->blockSize; ++t) {
-                int colA = startColA + t;
-                int rowB = startRowB + t;
-                if (colA < endColA && rowB < endRowB) {
-                    sum += (*args->matrixA)[i][colA] * (*args->matrixB)[rowB][j];
+            auto kernelFor = [&](const std::string& name) -> const GemmKernel<T, Acc>* {
+                for (const GemmKernel<T, Acc>* kernel : tuneKernels) {
+                    if (name == kernel->name) {
+                        return kernel;
+                    }
+                }
+                return nullptr;
+            };
+            auto runConfig = [&](const TunedConfig& config) {
+                size_t taskCount = 0;
+                return multiplyBlocked(ScheduleMode::Packed, kernelFor(config.isa), poolFor(config.threads),
+                                       config.blockSize, matrixA, matrixB, parallelResult, taskCount);
+            };
+
+            const TuneShape shape = { Type, size, size, size };
+            const std::string shapeKey = shapeClass(shape);
+            TunedConfig config;
+            std::string source = "source=database";
+            // An entry from another machine may name a kernel or more
+            // threads than this one has; tune again then.
+            if (options.retune || !environment.tuning->find(shapeKey, config) || !kernelFor(config.isa) ||
+                config.threads > ThreadPool::hardwareConcurrency()) {
+                // The search starts from the first ISA: the one auto picks.
+                std::vector<std::string> isas;
+                for (const GemmKernel<T, Acc>* kernel : tuneKernels) {
+                    isas.push_back(kernel->name);
+                }
+                auto preferred = std::find(isas.begin(), isas.end(), selectGemmKernel<T, Acc>("auto").name);
+                std::rotate(isas.begin(), preferred != isas.end() ? preferred : isas.begin(), isas.end());
+                const TuneSpace space = defaultTuneSpace(shape, isas, ThreadPool::hardwareConcurrency());
+                auto tuneStart = std::chrono::steady_clock::now();
+                TuneResult tuned = autoTune(space, [&](const TunedConfig& candidate) {
+                    runConfig(candidate);
+                    std::vector<long long> samples;
+                    for (int i = 0; i < 3; ++i) {
+                        samples.push_back(runConfig(candidate));
+                    }
+                    return summarizeTimings(samples).medianNs;
+                }, options.tuneBudget);
+                const long long tuneNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - tuneStart).count();
+                config = tuned.best;
+                source = "source=search evaluations=" + std::to_string(tuned.evaluations) +
+                         " tune_ms=" + std::to_string(tuneNs / 1000000);
+                std::cout << "Tune " << shapeKey << ": " << config.describe() << " after " << tuned.evaluations
+                          << " of " << space.isas.size() * space.blockSizes.size() * space.threads.size()
+                          << " configurations in " << tuneNs / 1e6 << " ms\n";
+                environment.tuning->store(shapeKey, config);
+                try {
+                    environment.tuning->save();
+                } catch (const std::exception& error) {
+                    std::cerr << "warning: tuning not saved: " << error.what() << "\n";
                 }
             }
-            std::lock_guard<std::mutex> lock(resultMutex);
-            (*args->resultMatrix)[i][j] += sum;
-        }
-    }
-    
-    delete args;
-    return nullptr;
-}
-
-int main() {
-    const int size = 32;
-    const unsigned maxThreads = 64;
-    
-    std::vector<std::vector<int>> matrixA(size, std::vector<int>(size));
-    std::vector<std::vector<int>> matrixB(size, std::vector<int>(size));
-    std::vector<std::vector<int>> referenceResult(size, std::vector<int>(size, 0));
-    std::vector<std::vector<int>> parallelResult(size, std::vector<int>(size, 0));
-
-    fillRandom(matrixA, 1, 100);
-    fillRandom(matrixB, 1, 100);
-
-    long long naiveTime = multiplyNaive(matrixA, matrixB, referenceResult);
-    std::cout << "Naive " << size << "x" << size << " : " << naiveTime << " ms\n";
-
-    for (int blockSize = 1; blockSize <= size; ++blockSize) {
-        for (auto& row : parallelResult) {
-            std::fill(row.begin(), row.end(), 0);
-        }
-        
-        int blocksPerDim = (size + blockSize - 1) / blockSize;
-        std::vector<pthread_t> activeThreads;
-        size_t threadsCreated = 0;
-        
-        auto startTime = std::chrono::high_resolution_clock::now();
-        
-        for (int blockI = 0; blockI < blocksPerDim; ++blockI) {
-            for (int blockJ = 0; blockJ < blocksPerDim; ++blockJ) {
-                for (int blockK = 0; blockK < blocksPerDim; ++blockK) {
-                    while (activeThreads.size() >= maxThreads) {
-                        pthread_join(activeThreads.front(), nullptr);
-                        activeThreads.erase(activeThreads.begin());
+
+            Mismatch mismatch;
+            std::vector<long long> samples = measure(options, [&] { return runConfig(config); },
+                                                     check, tolerance, mismatch, nullptr);
+            BenchRecord record = makeRecord(size, config.threads, dtype, "tuned", kernelFor(config.isa)->name,
+                                            config.blockSize, source, samples, mismatch);
+            printRecord(record, 0.0);
+            environment.records.push_back(record);
+        }
+
+        for (unsigned threadCount : options.threads) {
+            ThreadPool pool(threadCount, environment.cpusFor(threadCount));
+            environment.checkPinned("pool", pool.pinnedWorkers(), pool.size());
+            // Created on first use so its workers do not compete with the
+            // pool while other algorithms run.
+            std::unique_ptr<WorkStealingScheduler> scheduler;
+            // Median of the mutex path per backend and block size, for
+            // speedup_vs_mutex.
+            std::map<std::pair<std::string, int>, double> mutexMedians;
+            // Median of goto per micro-kernel, for the strassen crossover.
+            std::map<std::string, double> gotoMedians;
+            std::unique_ptr<PerfMonitor> perf = monitorPool(options, pool);
+
+            auto report = [&](const std::string& algorithm, const char* isa, int blockSize,
+                              const std::string& details, const std::vector<long long>& samples, const Mismatch& mismatch,
+                              const std::string& backend = "pool") {
+                const double flops = 2.0 * size * size * size;
+                const bool counted = perf && backend == "pool";
+                std::string allDetails = details;
+                if (counted) {
+                    const std::string counts = perf->total().dividedBy(samples.size()).describe(flops);
+                    allDetails += (allDetails.empty() ? "" : " ") + counts;
+                }
+                BenchRecord record = makeRecord(size, pool.size(), dtype, algorithm, isa, blockSize,
+                                                allDetails, samples, mismatch);
+                record.backend = backend;
+
+                // k of strassen is its cutoff, not a block size.
+                auto mutexMedian = algorithm == "strassen" ? mutexMedians.end()
+                                                           : mutexMedians.find(std::make_pair(backend, blockSize));
+                printRecord(record, mutexMedian != mutexMedians.end() ? mutexMedian->second : 0.0);
+                if (counted && options.perf == "threads") {
+                    printThreadCounts(*perf, samples.size(), flops);
+                }
+                if (algorithm == "mutex") {
+                    mutexMedians[std::make_pair(backend, blockSize)] = record.medianNs;
+                } else if (algorithm == "goto") {
+                    gotoMedians[isa] = record.medianNs;
+                }
+                environment.records.push_back(record);
+            };
+
+            for (const std::string& algorithm : options.algorithms) {
+                if (algorithm == "tuned" || algorithm == "gemm" || algorithm == "batched") {
+                    continue;
+                }
+                Mismatch mismatch;
+                if (algorithm == "naive") {
+                    std::vector<long long> samples = measure(options, [&] {
+                        return multiplyNaive(matrixA, matrixB, parallelResult);
+                    }, check, tolerance, mismatch, perf.get());
+                    report(algorithm, "scalar", 0, "", samples, mismatch);
+                    continue;
+                }
+                if (algorithm == "goto") {
+                    for (const GemmKernel<T, Acc>* kernel : kernels) {
+                        const CacheBlocking blocking = configuredBlocking(options, *kernel);
+                        std::vector<long long> samples = measure(options, [&] {
+                            return multiplyGotoBlocked(*kernel, blocking, pool, matrixA, matrixB, parallelResult);
+                        }, check, tolerance, mismatch, perf.get());
+                        report(algorithm, kernel->name, 0, toString(blocking), samples, mismatch);
+                    }
+                    continue;
+                }
+
+                if (algorithm == "ooc") {
+                    // The inputs go through the same tiled files a larger than
+                    // memory run would use; C is read back for the check.
+                    const size_t tileSize = std::min(options.oocTile, size);
+                    const std::string prefix = options.oocDir + "/ooc-" + dtype + "-n" + std::to_string(size) +
+                                               "-" + std::to_string(::getpid());
+                    ScratchFiles scratch = { { prefix + "-a.tmx", prefix + "-b.tmx", prefix + "-c.tmx" } };
+                    writeTiledMatrix(scratch.paths[0], Type, matrixA, tileSize);
+                    writeTiledMatrix(scratch.paths[1], Type, matrixB, tileSize);
+                    const TiledMatrixFile fileA = TiledMatrixFile::open(scratch.paths[0]);
+                    const TiledMatrixFile fileB = TiledMatrixFile::open(scratch.paths[1]);
+                    std::unique_ptr<AsyncReader> reader = createAsyncReader(options.io);
+                    for (const GemmKernel<T, Acc>* kernel : kernels) {
+                        const CacheBlocking blocking = configuredBlocking(options, *kernel);
+                        OutOfCoreStats stats;
+                        std::vector<long long> samples = measure(options, [&] {
+                            TiledMatrixFile fileC = TiledMatrixFile::create(scratch.paths[2], Type, sizeof(Acc),
+                                                                            size, size, tileSize);
+                            auto startTime = std::chrono::steady_clock::now();
+                            stats = multiplyOutOfCore(*kernel, blocking, pool, *reader, options.oocPrefetch,
+                                                      fileA, fileB, fileC);
+                            auto endTime = std::chrono::steady_clock::now();
+                            readTiledMatrix(fileC, parallelResult);
+                            return std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+                        }, check, tolerance, mismatch, perf.get());
+                        report(algorithm, kernel->name, static_cast<int>(tileSize), stats.describe(), samples, mismatch);
+                    }
+                    continue;
+                }
+
+                if (algorithm == "strassen") {
+                    // For int64, Strassen computes in the wrapping int ring
+                    // and C is widened afterwards. That is exact while the
+                    // sums fit in an int, i.e. below the size at which
+                    // int32 starts to wrap.
+                    constexpr bool widened = !std::is_same<T, Acc>::value;
+                    if (widened && !int32SumsFit(size)) {
+                        std::cout << "strassen: skipped for " << dtype << " at size " << size
+                                  << ", sums in its int ring would wrap\n";
+                        continue;
                     }
-                    
-                    BlockArgs* args = new BlockArgs;
-                    args->matrixA = &matrixA;
-                    args->matrixB = &matrixB;
-                    args->resultMatrix = &parallelResult;
-                    args->blockRowA = blockI;
-                    args->blockColA = blockK;
-                    args->blockRowB = blockK;
-                    args->blockColB = blockJ;
-                    args->blockSize = blockSize;
-                    
-                    pthread_t thread;
-                    if (pthread_create(&thread, nullptr, multiplyBlockWorker, args) == 0) {
-                        activeThreads.push_back(thread);
-                        ++threadsCreated;
-                    } else {
-                        delete args;
+                    Matrix<T> product = widened ? Matrix<T>(size, size) : Matrix<T>();
+                    for (int cutoff : options.cutoffs) {
+                        for (const GemmKernel<T, Acc>* kernel : kernels) {
+                            StrassenMultiplier<T> strassen(operandTypeKernel(*kernel), size, cutoff);
+                            // Each level adds error through the S/T differences;
+                            // measured at well under size * epsilon, so
+                            // doubling the bound per level leaves headroom.
+                            const double strassenTolerance =
+                                relativeTolerance<Acc>(size, std::pow(2.0, strassen.depth()));
+                            std::vector<long long> samples = measure(options, [&] {
+                                return multiplyStrassenTimed(strassen, pool, matrixA, matrixB, product, parallelResult);
+                            }, check, strassenTolerance, mismatch, perf.get());
+                            std::string details = "padded=" + std::to_string(strassen.paddedSize()) +
+                                                  " depth=" + std::to_string(strassen.depth()) +
+                                                  " arena_mb=" + std::to_string(strassen.arenaBytes() >> 20);
+                            auto gotoMedian = gotoMedians.find(kernel->name);
+                            if (gotoMedian != gotoMedians.end()) {
+                                double medianNs = summarizeTimings(samples).medianNs;
+                                std::ostringstream speedup;
+                                speedup << " speedup_vs_goto=" << (medianNs > 0.0 ? gotoMedian->second / medianNs : 0.0);
+                                details += speedup.str();
+                            }
+                            report(algorithm, kernel->name, cutoff, details, samples, mismatch);
+                        }
+                    }
+                    continue;
+                }
+
+                if (algorithm == "steal") {
+                    if (!scheduler) {
+                        scheduler.reset(new WorkStealingScheduler(threadCount, environment.cpusFor(threadCount)));
+                        environment.checkPinned("steal", scheduler->pinnedWorkers(), scheduler->size());
+                        if (perf) {
+                            std::vector<pid_t> workerIds = scheduler->threadIds();
+                            for (size_t i = 0; i < workerIds.size(); ++i) {
+                                perf->addThread("steal" + std::to_string(i), workerIds[i]);
+                            }
+                        }
+                    }
+                    for (int blockSize : blockSizesFor(options, size)) {
+                        for (const GemmKernel<T, Acc>* kernel : kernels) {
+                            size_t taskCount = 0;
+                            uint64_t splitCount = 0;
+                            std::vector<long long> samples = measure(options, [&] {
+                                return multiplyStealing(*kernel, *scheduler, blockSize,
+                                                        matrixA, matrixB, parallelResult, taskCount, splitCount);
+                            }, check, tolerance, mismatch, perf.get());
+                            WorkStealingScheduler::Stats stats = scheduler->stats();
+                            report(algorithm, kernel->name, blockSize,
+                                   "tasks=" + std::to_string(taskCount) +
+                                   " splits=" + std::to_string(splitCount) +
+                                   " steals=" + std::to_string(stats.steals) +
+                                   " failed_steals=" + std::to_string(stats.failedSteals) +
+                                   " idle_waits=" + std::to_string(stats.idleWaits),
+                                   samples, mismatch);
+                        }
+                    }
+                    continue;
+                }
+
+                ScheduleMode mode = ScheduleMode::Mutex;
+                parseScheduleMode(algorithm, mode);
+                std::vector<const GemmKernel<T, Acc>*> modeKernels = kernels;
+                if (mode != ScheduleMode::Packed) {
+                    modeKernels = { nullptr };
+                }
+                // The spawners start their threads inside the timed runs,
+                // which is the cost they are here to show. Their threads come
+                // and go, so only the pool is counted by --perf.
+                PthreadSpawner pthreads(pool.size(), environment.cpusFor(threadCount));
+                StdThreadSpawner stdThreads(pool.size(), environment.cpusFor(threadCount));
+                for (const std::string& backend : options.backends) {
+                    for (int blockSize : blockSizesFor(options, size)) {
+                        for (const GemmKernel<T, Acc>* kernel : modeKernels) {
+                            size_t taskCount = 0;
+                            auto multiply = [&] {
+                                if (backend == "pthread") {
+                                    return multiplyBlocked(mode, kernel, pthreads, blockSize,
+                                                           matrixA, matrixB, parallelResult, taskCount);
+                                }
+                                if (backend == "thread") {
+                                    return multiplyBlocked(mode, kernel, stdThreads, blockSize,
+                                                           matrixA, matrixB, parallelResult, taskCount);
+                                }
+                                return multiplyBlocked(mode, kernel, pool, blockSize,
+                                                       matrixA, matrixB, parallelResult, taskCount);
+                            };
+                            std::vector<long long> samples = measure(options, multiply, check, tolerance, mismatch,
+                                                                     backend == "pool" ? perf.get() : nullptr);
+                            report(algorithm, kernel ? kernel->name : "scalar", blockSize,
+                                   "tasks=" + std::to_string(taskCount), samples, mismatch, backend);
+                        }
                     }
                 }
             }
         }
-        
-        for (auto& thread : activeThreads) {
-            pthread_join(thread, nullptr);
+    }
+}
+
+// The gemm and batched algorithms: the rectangular products of
+// --gemm-shapes through gemm(), and the stacks of small square products of
+// --batches through gemmStridedBatched(), against a naive reference.
+template <ElementType Type>
+void runShapeBenchmarks(const BenchEnvironment& environment) {
+    using T = typename ElementTraits<Type>::Element;
+    using Acc = typename ElementTraits<Type>::Accumulator;
+    const BenchOptions& options = environment.options;
+    const char* dtype = elementTypeName(Type);
+    auto requested = [&](const char* algorithm) {
+        return std::find(options.algorithms.begin(), options.algorithms.end(), algorithm) != options.algorithms.end();
+    };
+
+    std::vector<const GemmKernel<T, Acc>*> kernels;
+    if (options.isa == "all") {
+        kernels = supportedGemmKernels<T, Acc>();
+    } else {
+        kernels.push_back(&selectGemmKernel<T, Acc>(options.isa));
+    }
+    unsigned maxThreads = 0;
+    for (unsigned threadCount : options.threads) {
+        maxThreads = std::max(maxThreads, environment.resolvedThreads(threadCount));
+    }
+    ThreadPool helper(maxThreads, environment.cpusFor(maxThreads));
+
+    auto timed = [](auto multiply) {
+        auto startTime = std::chrono::steady_clock::now();
+        multiply();
+        auto endTime = std::chrono::steady_clock::now();
+        return static_cast<long long>(std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count());
+    };
+    // count products of m x k by k x n per run.
+    auto report = [&](ThreadPool& pool, PerfMonitor* perf, const std::string& algorithm, const char* isa,
+                      const std::string& shape, int m, int n, int k, int count, std::string details,
+                      const std::vector<long long>& samples, const Mismatch& mismatch) {
+        const double flops = 2.0 * m * n * k * count;
+        if (perf) {
+            details += (details.empty() ? "" : " ") + perf->total().dividedBy(samples.size()).describe(flops);
+        }
+        BenchRecord record = makeRecord(0, pool.size(), dtype, algorithm, isa, 0, details, samples, mismatch);
+        record.shape = shape;
+        record.gops = gigaOpsPerSecond(m, n, k, record.medianNs) * count;
+        printRecord(record, 0.0);
+        if (perf && options.perf == "threads") {
+            printThreadCounts(*perf, samples.size(), flops);
         }
-        
-        auto endTime = std::chrono::high_resolution_clock::now();
-        long long parallelTime = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count();
+        environment.records.push_back(record);
+    };
 
-        bool isCorrect = true;
-        for (int i = 0; i < size && isCorrect; ++i) {
-            for (int j = 0; j < size && isCorrect; ++j) {
-                if (referenceResult[i][j] != parallelResult[i][j]) {
-                    isCorrect = false;
+    if (requested("gemm")) {
+        for (const GemmShape& shape : options.gemmShapes) {
+            const std::string name = std::to_string(shape.m) + "x" + std::to_string(shape.n) + "x" +
+                                     std::to_string(shape.k);
+            Matrix<T> matrixA(shape.m, shape.k);
+            Matrix<T> matrixB(shape.k, shape.n);
+            Matrix<Acc> result(shape.m, shape.n);
+            Matrix<Acc> reference(shape.m, shape.n);
+            fillRandom<T>(helper, matrixA, environment.seed, 0, 1, 100);
+            fillRandom<T>(helper, matrixB, environment.seed, 1, 1, 100);
+            naiveProduct<T, Acc>(matrixA.view(), matrixB.view(), reference.view());
+            auto check = [&](double allowed) { return compareMatrices(helper, reference, result, allowed); };
+
+            for (unsigned threadCount : options.threads) {
+                ThreadPool pool(threadCount, environment.cpusFor(threadCount));
+                environment.checkPinned("pool", pool.pinnedWorkers(), pool.size());
+                std::unique_ptr<PerfMonitor> perf = monitorPool(options, pool);
+                for (const GemmKernel<T, Acc>* kernel : kernels) {
+                    Mismatch mismatch;
+                    std::vector<long long> samples = measure(options, [&] {
+                        return timed([&] {
+                            gemm(*kernel, pool, shape.m, shape.n, shape.k, matrixA.data(), matrixA.stride(),
+                                 matrixB.data(), matrixB.stride(), result.data(), result.stride());
+                        });
+                    }, check, relativeTolerance<Acc>(shape.k), mismatch, perf.get());
+                    const bool parallel = static_cast<double>(shape.m) * shape.n * shape.k >= gemmParallelOps;
+                    report(pool, perf.get(), "gemm", kernel->name, name, shape.m, shape.n, shape.k, 1,
+                           parallel ? "path=goto" : "path=serial", samples, mismatch);
                 }
             }
         }
+    }
+
+    if (requested("batched")) {
+        for (const BatchShape& batch : options.batches) {
+            const int size = batch.size;
+            const size_t count = static_cast<size_t>(batch.count);
+            const std::string name = std::to_string(batch.count) + "x" + std::to_string(size);
+            // The products stacked vertically: X_i is rows [i * size, (i + 1) * size).
+            Matrix<T> matrixA(count * size, size);
+            Matrix<T> matrixB(count * size, size);
+            Matrix<Acc> result(count * size, size);
+            Matrix<Acc> reference(count * size, size);
+            fillRandom<T>(helper, matrixA, environment.seed, 0, 1, 100);
+            fillRandom<T>(helper, matrixB, environment.seed, 1, 1, 100);
+            for (size_t i = 0; i < count; ++i) {
+                naiveProduct<T, Acc>(matrixA.tile(i * size, 0, size, size), matrixB.tile(i * size, 0, size, size),
+                                     reference.tile(i * size, 0, size, size));
+            }
+            auto check = [&](double allowed) { return compareMatrices(helper, reference, result, allowed); };
+            const size_t strideA = size * matrixA.stride();
+            const size_t strideB = size * matrixB.stride();
+            const size_t strideC = size * result.stride();
+
+            for (unsigned threadCount : options.threads) {
+                ThreadPool pool(threadCount, environment.cpusFor(threadCount));
+                environment.checkPinned("pool", pool.pinnedWorkers(), pool.size());
+                std::unique_ptr<PerfMonitor> perf = monitorPool(options, pool);
+                for (const GemmKernel<T, Acc>* kernel : kernels) {
+                    // What a caller without the batched entry point would do.
+                    Mismatch loopMismatch;
+                    std::vector<long long> loopSamples = measure(options, [&] {
+                        return timed([&] {
+                            for (size_t i = 0; i < count; ++i) {
+                                gemm(*kernel, pool, size, size, size, matrixA.data() + i * strideA, matrixA.stride(),
+                                     matrixB.data() + i * strideB, matrixB.stride(),
+                                     result.data() + i * strideC, result.stride());
+                            }
+                        });
+                    }, check, relativeTolerance<Acc>(size), loopMismatch, nullptr);
+
+                    Mismatch mismatch;
+                    std::vector<long long> samples = measure(options, [&] {
+                        return timed([&] {
+                            gemmStridedBatched(*kernel, pool, size, size, size, matrixA.data(), matrixA.stride(),
+                                               strideA, matrixB.data(), matrixB.stride(), strideB,
+                                               result.data(), result.stride(), strideC, count);
+                        });
+                    }, check, relativeTolerance<Acc>(size), mismatch, perf.get());
+                    if (loopMismatch.found) {
+                        mismatch = loopMismatch;
+                    }
+                    const double medianNs = summarizeTimings(samples).medianNs;
+                    std::ostringstream details;
+                    details << "speedup_vs_loop="
+                            << (medianNs > 0.0 ? summarizeTimings(loopSamples).medianNs / medianNs : 0.0);
+                    report(pool, perf.get(), "batched", kernel->name, name, size, size, size, batch.count,
+                           details.str(), samples, mismatch);
+                }
+            }
+        }
+    }
+}
+
+// --ooc-generate: the first --sizes and --dtype, written tile by tile so
+// the matrix never has to fit in memory. Values match what fillRandom puts
+// into matrix A for the same seed.
+template <ElementType Type>
+void generateTiledFile(const BenchEnvironment& environment) {
+    using T = typename ElementTraits<Type>::Element;
+    const BenchOptions& options = environment.options;
+    const size_t size = options.sizes.front();
+    TiledMatrixFile file = TiledMatrixFile::create(options.oocGenerate, Type, sizeof(T), size, size, options.oocTile);
+    const size_t tileSize = file.tileSize();
+    Matrix<T> tile(1, tileSize * tileSize);
+    for (size_t tileRow = 0; tileRow < file.tileRows(); ++tileRow) {
+        for (size_t tileCol = 0; tileCol < file.tileCols(); ++tileCol) {
+            // Only edge tiles have padding; clear what the previous tile
+            // left there.
+            std::fill(tile.data(), tile.data() + tileSize * tileSize, T());
+            MatrixView<T> block(tile.data(), file.tileHeight(tileRow), file.tileWidth(tileCol), tileSize);
+            fillRandomBlock<T>(block, tileRow * tileSize, tileCol * tileSize, size, environment.seed, 0, 1, 100);
+            file.writeTile(tileRow, tileCol, tile.data());
+        }
+    }
+    std::cout << "Wrote " << file.path() << ": " << size << "x" << size << " " << elementTypeName(Type)
+              << " tile=" << tileSize << "\n";
+}
+
+// --ooc-multiply: C = A * B over tiled files with the type stored in A.
+template <ElementType Type>
+void multiplyTiledFiles(const BenchEnvironment& environment) {
+    using T = typename ElementTraits<Type>::Element;
+    using Acc = typename ElementTraits<Type>::Accumulator;
+    const BenchOptions& options = environment.options;
+    const TiledMatrixFile fileA = TiledMatrixFile::open(options.oocMultiply[0]);
+    const TiledMatrixFile fileB = TiledMatrixFile::open(options.oocMultiply[1]);
+    if (fileB.elementType() != Type) {
+        throw std::invalid_argument(fileB.path() + " holds " + elementTypeName(fileB.elementType()) + ", " +
+                                    fileA.path() + " holds " + elementTypeName(Type));
+    }
+    TiledMatrixFile fileC = TiledMatrixFile::create(options.oocMultiply[2], Type, sizeof(Acc),
+                                                    fileA.rows(), fileB.cols(), fileA.tileSize());
+    const GemmKernel<T, Acc>& kernel = selectGemmKernel<T, Acc>(options.isa == "all" ? "auto" : options.isa);
+    const unsigned threadCount = options.threads.front();
+    ThreadPool pool(threadCount, environment.cpusFor(threadCount));
+    environment.checkPinned("pool", pool.pinnedWorkers(), pool.size());
+
+    std::unique_ptr<AsyncReader> reader = createAsyncReader(options.io);
+
+    auto startTime = std::chrono::steady_clock::now();
+    OutOfCoreStats stats = multiplyOutOfCore(kernel, configuredBlocking(options, kernel), pool,
+                                             *reader, options.oocPrefetch, fileA, fileB, fileC);
+    auto endTime = std::chrono::steady_clock::now();
+    const double ns = std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+    std::cout << "ooc " << fileA.path() << " x " << fileB.path() << " -> " << fileC.path()
+              << " dtype=" << elementTypeName(Type) << " isa=" << kernel.name << " threads=" << pool.size()
+              << " tile=" << fileA.tileSize() << " time_ms=" << ns / 1e6
+              << " gops=" << gigaOpsPerSecond(fileA.rows(), fileB.cols(), fileA.cols(), ns)
+              << " " << stats.describe() << "\n";
+}
+
+// --trace: every thread's events as Chrome trace JSON. Returns the exit
+// code, non-zero when the file cannot be written.
+int writeTraceFile(const BenchOptions& options) {
+    if (options.tracePath.empty()) {
+        return 0;
+    }
+    std::ofstream traceFile(options.tracePath);
+    if (!traceFile) {
+        std::cerr << "Cannot write trace to " << options.tracePath << "\n";
+        return 1;
+    }
+    size_t events = writeChromeTrace(traceFile);
+    std::cout << "Trace written to " << options.tracePath << " (" << events << " events)\n";
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    try {
+        options = parseBenchOptions(argc, argv);
+        if (options.isa != "all") {
+            selectGemmKernel<int>(options.isa);
+        }
+    } catch (const std::exception& error) {
+        std::cerr << error.what() << "\n";
+        printBenchUsage(std::cerr, argv[0]);
+        return 1;
+    }
+    if (options.help) {
+        printBenchUsage(std::cout, argv[0]);
+        return 0;
+    }
+
+    const Topology topology = detectTopology();
+    const bool pinned = options.placement.policy != PlacementPolicy::None;
+    // With a single node there is nowhere better to put the pages, so the
+    // placement only pins the workers.
+    const bool placeMemory = pinned && topology.nodeCount > 1;
+    std::cout << "Topology: " << topology.describe() << " placement=" << options.placement.describe()
+              << (pinned && !placeMemory ? " (single node, first-touch skipped)" : "") << "\n";
+
+    uint64_t seed = options.seed;
+    if (seed == 0) {
+        std::random_device rd;
+        seed = (static_cast<uint64_t>(rd()) << 32 | rd()) | 1;
+    }
+    std::cout << "Seed: " << seed << " (pass --seed=" << seed << " to reproduce the inputs)\n";
+    warnInt32Overflow(options);
+
+    if (!options.cacheDir.empty() && ::mkdir(options.cacheDir.c_str(), 0755) != 0 && errno != EEXIST) {
+        std::cerr << "Cannot create cache directory " << options.cacheDir << ": " << std::strerror(errno) << "\n";
+        return 1;
+    }
+
+    if (options.perf != "off") {
+        PerfMonitor probe;
+        probe.addThread("main", currentThreadId());
+        if (!probe.available()) {
+            std::cout << "Perf counters: unavailable, " << probe.unavailableReason() << "; running without them\n";
+            options.perf = "off";
+        }
+    }
 
-        std::cout << "k=" << blockSize
-                  << " blocksPerDim=" << blocksPerDim
-                  << " threadsCreated=" << threadsCreated
-                  << " time_ms=" << parallelTime
-                  << " correct=" << (isCorrect ? "YES" : "NO") << "\n";
+    TRACE_THREAD_NAME("main");
+    std::vector<BenchRecord> records;
+    std::unique_ptr<TuningDatabase> tuning;
+    if (std::find(options.algorithms.begin(), options.algorithms.end(), "tuned") != options.algorithms.end()) {
+        tuning.reset(new TuningDatabase(options.tuneDb));
     }
-    
+    const BenchEnvironment environment = { options, topology, pinned, placeMemory, seed, records, tuning.get() };
+    try {
+        if (!options.oocGenerate.empty()) {
+            dispatchElementType(options.elementTypes.front(), [&](auto tag) {
+                generateTiledFile<decltype(tag)::value>(environment);
+            });
+            return writeTraceFile(options);
+        }
+        if (!options.oocMultiply.empty()) {
+            dispatchElementType(TiledMatrixFile::open(options.oocMultiply[0]).elementType(), [&](auto tag) {
+                multiplyTiledFiles<decltype(tag)::value>(environment);
+            });
+            return writeTraceFile(options);
+        }
+        // Square runs fill and check size x size inputs, which the shape
+        // algorithms do not use, so they only start when one is requested.
+        auto shapeAlgorithm = [](const std::string& algorithm) { return algorithm == "gemm" || algorithm == "batched"; };
+        const bool squareRuns = !std::all_of(options.algorithms.begin(), options.algorithms.end(), shapeAlgorithm);
+        const bool shapeRuns = std::any_of(options.algorithms.begin(), options.algorithms.end(), shapeAlgorithm);
+        for (ElementType type : options.elementTypes) {
+            dispatchElementType(type, [&](auto tag) {
+                if (squareRuns) {
+                    runBenchmarks<decltype(tag)::value>(environment);
+                }
+                if (shapeRuns) {
+                    runShapeBenchmarks<decltype(tag)::value>(environment);
+                }
+            });
+        }
+    } catch (const std::exception& error) {
+        std::cerr << error.what() << "\n";
+        return 1;
+    }
+
+    if (writeTraceFile(options) != 0) {
+        return 1;
+    }
+
+    if (!options.reportFormat.empty()) {
+        std::string path = options.reportPath.empty() ? "matrix_report." + options.reportFormat : options.reportPath;
+        std::ofstream reportFile(path);
+        if (!reportFile) {
+            std::cerr << "Cannot write report to " << path << "\n";
+            return 1;
+        }
+        HostInfo host = collectHostInfo();
+        host.placement = options.placement.describe();
+        if (options.reportFormat == "json") {
+            writeJsonReport(reportFile, host, records);
+        } else {
+            writeCsvReport(reportFile, host, records);
+        }
+        std::cout << "Report written to " << path << "\n";
+    }
+
+    if (!options.comparePath.empty()) {
+        std::ifstream baselineFile(options.comparePath);
+        if (!baselineFile) {
+            std::cerr << "Cannot read baseline " << options.comparePath << "\n";
+            return 1;
+        }
+        try {
+            std::vector<BenchRecord> baseline = readJsonReport(baselineFile);
+            if (compareWithBaseline(records, baseline, options.regressionThreshold, std::cout) > 0) {
+                return 2;
+            }
+        } catch (const std::exception& error) {
+            std::cerr << error.what() << "\n";
+            return 1;
+        }
+    }
+
     return 0;
-}
\ No newline at end of file
+}
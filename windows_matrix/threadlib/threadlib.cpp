@@ -6,33 +6,35 @@
 #include <random>
 #include <mutex>
 #include <fstream>
+#include "Matrix.h"
 
 std::mutex resultMutex;
 
-void fillRandom(std::vector<std::vector<int>>& matrix, int minValue = 1, int maxValue = 10) {
+void fillRandom(Matrix<int>& matrix, int minValue = 1, int maxValue = 10) {
     std::random_device rd;
     std::mt19937 gen(rd());
     std::uniform_int_distribution<> dist(minValue, maxValue);
-    for (auto& row : matrix) {
-        for (auto& element : row) {
-            element = dist(gen);
+    for (size_t i = 0; i < matrix.rows(); ++i) {
+        int* row = matrix.row(i);
+        for (size_t j = 0; j < matrix.cols(); ++j) {
+            row[j] = dist(gen);
         }
     }
 }
 
-long long multiplyNaive(const std::vector<std::vector<int>>& matrixA,
-    const std::vector<std::vector<int>>& matrixB,
-    std::vector<std::vector<int>>& resultMatrix) {
-    int size = matrixA.size();
+long long multiplyNaive(const Matrix<int>& matrixA,
+    const Matrix<int>& matrixB,
+    Matrix<int>& resultMatrix) {
+    int size = (int)matrixA.rows();
     auto startTime = std::chrono::high_resolution_clock::now();
 
     for (int i = 0; i < size; ++i) {
         for (int j = 0; j < size; ++j) {
             int sum = 0;
             for (int k = 0; k < size; ++k) {
-                sum += matrixA[i][k] * matrixB[k][j];
+                sum += matrixA(i, k) * matrixB(k, j);
             }
-            resultMatrix[i][j] = sum;
+            resultMatrix(i, j) = sum;
         }
     }
 
@@ -40,11 +42,11 @@ long long multiplyNaive(const std::vector<std::vector<int>>& matrixA,
     return std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count();
 }
 
-void multiplyBlock(const std::vector<std::vector<int>>& matrixA,
-    const std::vector<std::vector<int>>& matrixB,
-    std::vector<std::vector<int>>& resultMatrix,
+void multiplyBlock(const Matrix<int>& matrixA,
+    const Matrix<int>& matrixB,
+    Matrix<int>& resultMatrix,
     int blockRowA, int blockColA, int blockRowB, int blockColB, int blockSize) {
-    int size = matrixA.size();
+    int size = (int)matrixA.rows();
     int startRowA = blockRowA * blockSize;
     int endRowA = std::min((blockRowA + 1) * blockSize, size);
     int startColA = blockColA * blockSize;
@@ -61,11 +63,37 @@ void multiplyBlock(const std::vector<std::vector<int>>& matrixA,
                 int colA = startColA + t;
                 int rowB = startRowB + t;
                 if (colA < endColA && rowB < endRowB) {
-                    sum += matrixA[i][colA] * matrixB[rowB][j];
+                    sum += matrixA(i, colA) * matrixB(rowB, j);
                 }
             }
             std::lock_guard<std::mutex> lock(resultMutex);
-            resultMatrix[i][j] += sum;
+            resultMatrix(i, j) += sum;
+        }
+    }
+}
+
+void multiplyTile(const Matrix<int>& matrixA,
+    const Matrix<int>& matrixB,
+    Matrix<int>& resultMatrix,
+    int blockRow, int blockCol, int blockSize) {
+    int size = (int)matrixA.rows();
+    int startRow = blockRow * blockSize;
+    int endRow = std::min((blockRow + 1) * blockSize, size);
+    int startCol = blockCol * blockSize;
+    int endCol = std::min((blockCol + 1) * blockSize, size);
+
+    // This thread is the only writer of the (blockRow, blockCol) tile of C,
+    // so the K panels are summed in place without taking resultMutex.
+    for (int startK = 0; startK < size; startK += blockSize) {
+        int endK = std::min(startK + blockSize, size);
+        for (int i = startRow; i < endRow; ++i) {
+            for (int j = startCol; j < endCol; ++j) {
+                int sum = 0;
+                for (int k = startK; k < endK; ++k) {
+                    sum += matrixA(i, k) * matrixB(k, j);
+                }
+                resultMatrix(i, j) += sum;
+            }
         }
     }
 }
@@ -74,10 +102,10 @@ int main() {
     const int size = 32;
     const unsigned maxThreads = 64;
 
-    std::vector<std::vector<int>> matrixA(size, std::vector<int>(size));
-    std::vector<std::vector<int>> matrixB(size, std::vector<int>(size));
-    std::vector<std::vector<int>> referenceResult(size, std::vector<int>(size, 0));
-    std::vector<std::vector<int>> parallelResult(size, std::vector<int>(size, 0));
+    Matrix<int> matrixA(size, size);
+    Matrix<int> matrixB(size, size);
+    Matrix<int> referenceResult(size, size);
+    Matrix<int> parallelResult(size, size);
 
     fillRandom(matrixA, 1, 100);
     fillRandom(matrixB, 1, 100);
@@ -86,57 +114,72 @@ int main() {
     std::cout << "Naive " << size << "x" << size << " : " << naiveTime << " ms\n";
 
     for (int blockSize = 1; blockSize <= size; ++blockSize) {
-        for (auto& row : parallelResult) {
-            std::fill(row.begin(), row.end(), 0);
-        }
-
-        int blocksPerDim = (size + blockSize - 1) / blockSize;
-        std::vector<std::thread> threadPool;
-        size_t threadsCreated = 0;
-
-        auto startTime = std::chrono::high_resolution_clock::now();
+        double mutexTime = 0.0;
+
+        for (bool ownerTiles : { false, true }) {
+            parallelResult.fill(0);
+
+            int blocksPerDim = (size + blockSize - 1) / blockSize;
+            int blocksK = ownerTiles ? 1 : blocksPerDim;
+            std::vector<std::thread> threadPool;
+            size_t threadsCreated = 0;
+
+            auto startTime = std::chrono::high_resolution_clock::now();
+
+            for (int blockI = 0; blockI < blocksPerDim; ++blockI) {
+                for (int blockJ = 0; blockJ < blocksPerDim; ++blockJ) {
+                    for (int blockK = 0; blockK < blocksK; ++blockK) {
+                        while (threadPool.size() >= maxThreads) {
+                            if (threadPool.front().joinable()) {
+                                threadPool.front().join();
+                            }
+                            threadPool.erase(threadPool.begin());
+                        }
 
-        for (int blockI = 0; blockI < blocksPerDim; ++blockI) {
-            for (int blockJ = 0; blockJ < blocksPerDim; ++blockJ) {
-                for (int blockK = 0; blockK < blocksPerDim; ++blockK) {
-                    while (threadPool.size() >= maxThreads) {
-                        if (threadPool.front().joinable()) {
-                            threadPool.front().join();
+                        if (ownerTiles) {
+                            threadPool.emplace_back(multiplyTile,
+                                std::cref(matrixA), std::cref(matrixB), std::ref(parallelResult),
+                                blockI, blockJ, blockSize);
                         }
-                        threadPool.erase(threadPool.begin());
+                        else {
+                            threadPool.emplace_back(multiplyBlock,
+                                std::cref(matrixA), std::cref(matrixB), std::ref(parallelResult),
+                                blockI, blockK, blockK, blockJ, blockSize);
+                        }
+                        ++threadsCreated;
                     }
-
-                    threadPool.emplace_back(multiplyBlock,
-                        std::cref(matrixA), std::cref(matrixB), std::ref(parallelResult),
-                        blockI, blockK, blockK, blockJ, blockSize);
-                    ++threadsCreated;
                 }
             }
-        }
 
-        for (auto& thread : threadPool) {
-            if (thread.joinable()) {
-                thread.join();
+            for (auto& thread : threadPool) {
+                if (thread.joinable()) {
+                    thread.join();
+                }
             }
-        }
 
-        auto endTime = std::chrono::high_resolution_clock::now();
-        long long parallelTime = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count();
+            auto endTime = std::chrono::high_resolution_clock::now();
+            double parallelTime = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+            if (!ownerTiles) {
+                mutexTime = parallelTime;
+            }
 
-        bool isCorrect = true;
-        for (int i = 0; i < size && isCorrect; ++i) {
-            for (int j = 0; j < size && isCorrect; ++j) {
-                if (referenceResult[i][j] != parallelResult[i][j]) {
-                    isCorrect = false;
+            bool isCorrect = true;
+            for (int i = 0; i < size && isCorrect; ++i) {
+                for (int j = 0; j < size && isCorrect; ++j) {
+                    if (referenceResult(i, j) != parallelResult(i, j)) {
+                        isCorrect = false;
+                    }
                 }
             }
-        }
 
-        std::cout << "k=" << blockSize
-            << " blocksPerDim=" << blocksPerDim
-            << " threadsCreated=" << threadsCreated
-            << " time_ms=" << parallelTime
-            << " correct=" << (isCorrect ? "YES" : "NO") << "\n";
+            std::cout << "k=" << blockSize
+                << " mode=" << (ownerTiles ? "owner" : "mutex")
+                << " blocksPerDim=" << blocksPerDim
+                << " threadsCreated=" << threadsCreated
+                << " time_ms=" << parallelTime
+                << " speedup_vs_mutex=" << (parallelTime > 0.0 ? mutexTime / parallelTime : 0.0)
+                << " correct=" << (isCorrect ? "YES" : "NO") << "\n";
+        }
     }
 
     return 0;
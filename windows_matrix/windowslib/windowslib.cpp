@@ -7,40 +7,42 @@
 #include <random>
 #include <mutex>
 #include <fstream>
+#include "Matrix.h"
 
 std::mutex resultMutex;
 
 struct BlockArgs {
-    const std::vector<std::vector<int>>* matrixA;
-    const std::vector<std::vector<int>>* matrixB;
-    std::vector<std::vector<int>>* resultMatrix;
+    const Matrix<int>* matrixA;
+    const Matrix<int>* matrixB;
+    Matrix<int>* resultMatrix;
     int blockRowA, blockColA, blockRowB, blockColB, blockSize;
 };
 
-void fillRandom(std::vector<std::vector<int>>& matrix, int minVal = 1, int maxVal = 10) {
+void fillRandom(Matrix<int>& matrix, int minVal = 1, int maxVal = 10) {
     std::random_device rd;
     std::mt19937 gen(rd());
     std::uniform_int_distribution<> dist(minVal, maxVal);
-    for (auto& row : matrix) {
-        for (auto& element : row) {
-            element = dist(gen);
+    for (size_t i = 0; i < matrix.rows(); ++i) {
+        int* row = matrix.row(i);
+        for (size_t j = 0; j < matrix.cols(); ++j) {
+            row[j] = dist(gen);
         }
     }
 }
 
-long long multiplyNaive(const std::vector<std::vector<int>>& matrixA,
-    const std::vector<std::vector<int>>& matrixB,
-    std::vector<std::vector<int>>& resultMatrix) {
-    int size = matrixA.size();
+long long multiplyNaive(const Matrix<int>& matrixA,
+    const Matrix<int>& matrixB,
+    Matrix<int>& resultMatrix) {
+    int size = (int)matrixA.rows();
     auto startTime = std::chrono::high_resolution_clock::now();
 
     for (int i = 0; i < size; ++i) {
         for (int j = 0; j < size; ++j) {
             int sum = 0;
             for (int k = 0; k < size; ++k) {
-                sum += matrixA[i][k] * matrixB[k][j];
+                sum += matrixA(i, k) * matrixB(k, j);
             }
-            resultMatrix[i][j] = sum;
+            resultMatrix(i, j) = sum;
         }
     }
 
@@ -50,7 +52,7 @@ long long multiplyNaive(const std::vector<std::vector<int>>& matrixA,
 
 DWORD WINAPI multiplyBlockWorker(LPVOID param) {
     BlockArgs* args = static_cast<BlockArgs*>(param);
-    int size = args->matrixA->size();
+    int size = (int)args->matrixA->rows();
 
     int startRowA = args->blockRowA * args->blockSize;
     int endRowA = std::min((args->blockRowA + 1) * args->blockSize, size);
@@ -69,11 +71,11 @@ DWORD WINAPI multiplyBlockWorker(LPVOID param) {
                 int colA = startColA + t;
                 int rowB = startRowB + t;
                 if (colA < endColA && rowB < endRowB) {
-                    sum += (*args->matrixA)[i][colA] * (*args->matrixB)[rowB][j];
+                    sum += (*args->matrixA)(i, colA) * (*args->matrixB)(rowB, j);
                 }
             }
             std::lock_guard<std::mutex> lock(resultMutex);
-            (*args->resultMatrix)[i][j] += sum;
+            (*args->resultMatrix)(i, j) += sum;
         }
     }
 
@@ -85,10 +87,10 @@ int main() {
     const int size = 32;
     const unsigned maxThreads = 64;
 
-    std::vector<std::vector<int>> matrixA(size, std::vector<int>(size));
-    std::vector<std::vector<int>> matrixB(size, std::vector<int>(size));
-    std::vector<std::vector<int>> referenceResult(size, std::vector<int>(size, 0));
-    std::vector<std::vector<int>> parallelResult(size, std::vector<int>(size, 0));
+    Matrix<int> matrixA(size, size);
+    Matrix<int> matrixB(size, size);
+    Matrix<int> referenceResult(size, size);
+    Matrix<int> parallelResult(size, size);
 
     fillRandom(matrixA, 1, 100);
     fillRandom(matrixB, 1, 100);
@@ -97,9 +99,7 @@ int main() {
     std::cout << "Naive " << size << "x" << size << " : " << naiveTime << " ms\n";
 
     for (int blockSize = 1; blockSize <= size; ++blockSize) {
-        for (auto& row : parallelResult) {
-            std::fill(row.begin(), row.end(), 0);
-        }
+        parallelResult.fill(0);
 
         int blocksPerDim = (size + blockSize - 1) / blockSize;
         std::vector<HANDLE> handles;
@@ -154,7 +154,7 @@ int main() {
         bool isCorrect = true;
         for (int i = 0; i < size && isCorrect; ++i) {
             for (int j = 0; j < size && isCorrect; ++j) {
-                if (referenceResult[i][j] != parallelResult[i][j]) {
+                if (referenceResult(i, j) != parallelResult(i, j)) {
                     isCorrect = false;
                 }
             }